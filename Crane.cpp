@@ -1,1196 +1,3203 @@
-/*
-***********************************************************************
-*					     ___ _____   _____ __  __ _____               *
-*					  / ____|  __ \ / ____|  \/  |  __ \              *
-*					 | |    | |  | | |  __| \  / | |  | |             *
-*					 | |    | |  | | | |_ | |\/| | |  | |             *
-*					 | |____| |__| | |__| | |  | | |__| |             *
-*					  \_____|_____/ \_____|_|  |_|_____/              *
-*					                                                  *
-***********************************************************************				                                     
-*
-*  Zuyd Crane Project
-*
-*  Copyright © 2022 Rafael de Bie
-*  Permission is hereby granted, free of charge, to any person obtaining a
-*  copy of this software and associated documentation files (the "Software"),
-*  to deal in the Software without restriction, including without limitation
-*  the rights to use, copy, modify, merge, publish, distribute, sublicense,
-*  and/or sell copies of the Software, and to permit persons to whom the
-*  Software is furnished to do so, subject to the following conditions:
-*
-*  The above copyright notice and this permission notice shall be included in all copies or 
-*  substantial portions of the Software.
-*
-*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
-*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
-*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
-*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
-*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
-*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*
-*************************************************************************
-*
-* The API for this library:
-*
-*
-*
-* Crane(uint8_t arduinoID): Crane Constructor
-* 	-> arduinoID: the ID of the arduino (1,2,3)
-* 
-* verify(): Calls the arduinos respective verify function
-* 
-* update(): Calls the arduinos respective update function
-* 
-* init():   Calls the arduinos respective init function
-* 
-* returnHC06Msg(): Checks for any message from the HC-06. Returns the incoming data as a string, if any
-* 
-* onReceive(): Automatically parses some basic I2C commands. It should be the first thing called in the implementation. Returns the incoming data as a string
-* 
-* subscribe(uint8_t index): Subscribes an index. Used to flag indicies which must be sent at a later time.
-* 	-> index: The index to be subscribed
-* 
-* sendData(uint8_t arduino, byte data): Sends a byte of data to arduino (read: address) 'arduino'.
-* 	-> arduino: the address of the arduino.
-* 	-> data: the byte to be sent
-* 	
-* sendData(uint8_t arduino, String data): Sends a string (as a sequence of bytes) to arduino (read: address) 'arduino'.
-* 	-> arduino: the address of the arduino.
-* 	-> data: the string to be sent
-* 
-* removeNFromBuffer(uint8_t n): removes 'n' amount of entries from the instruction buffer
-* 	-> n: the amount of instructions to remove
-* 	
-* readBuffer(): reads the latest entry in the buffer, returns it, and removes it from the buffer
-* 
-* available(): returns the amount of unread buffer entries
-* 
-* flushBuffer(): clears the buffer.
-* 
-* addToBuffer(String instruction): adds the instruction to the buffer
-* 	-> instruction: the instruction to be added
-* 
-* pushBuffer(uint8_t ardId, uint8_t n): Pushes (sends) subscribed indicies to arduino (read: address). Only checks 'n' indexes
-* 	-> ardId: the arduino to push to
-* 	-> n: the amount of indicies to send (if subscribed)
-* 
-* pushBuffer(uint8_t ardId): Pushes (sends) all subscribed indicies to arduino (read: address).
-* 	-> ardId: the arduino to push to
-*
-*
-************************
-*
-*
-* init1(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-*
-* update1(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-*
-* verify1(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-*
-*
-************************
-*
-*
-* init2(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-*
-* update2(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-*
-* verify2(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-* 
-* setSpeedOf(uint8_t stepper, float rps): Sets the speed of stepper 'stepper' to 'rps' (in rotations per second). Returns 0
-* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
-*	-> rps: the speed of the stepper motor in rotations per second. Note: the sign of this parameter determines the direction of the movement 
-* 
-* LCM(float n1, float n2, float n3): Returns the LCM of three numbers (rounded up).
-* 	-> n1: an arbitrary number
-* 	-> n2: an arbitrary number
-*	-> n3: an arbitrary number
-*
-* maX(uint8_t a, uint8_t b): Returns a if a > b. otherwise returns b
-*	-> a: an arbitrary number
-*	-> b: an arbitrary number
-*
-* stepSync(): Steps all motors in a synchronized manner
-*
-* step(uint8_t stepper): Steps the specified stepper once
-* 	-> stepper: the stepper id
-*
-* step(uint8_t stepper, bool direction): Steps the specified stepper once in a specified direction
-* 	-> stepper: the stepper id
-*	-> direction: the direction the stepper step
-*
-*
-************************
-*
-*
-* init3(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-*
-* update3(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-*
-* verify3(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-*
-* createCustomChars(): Creates the custom characters for the LCD screen
-
-
-************************************************************************
-*/
-
-
-
-
-
-
-#include "Arduino.h"
-#include "Crane.h"
-#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
-#include <inttypes.h>
-#include <stdint.h>
-#include "Wire.h"
-#include "LiquidCrystal.h"
-#include "Stepper.h"
-#include "SoftwareSerial.h"
- 
-using namespace std;
-
-/// The constructor of the crane class
-/// Doesnt do much, because the 'Constructing' happens at the 'init()'.
-///
-Crane::Crane(uint8_t arduinoID)
-{
-	//-------------------------------- Set own arduinoID to the parameter
-	_arduinoID = arduinoID;
-}
-
-/// This function initializes the board, to make it ready for operations
-/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
-///
-int Crane::verify()
-{
-	//-------------------------------- Divert the 'verify()' to the arduinos specific "verify()" functions
-	if(devMode) Serial.println("------------- Verifying board");
-	if(_arduinoID == 1) return verify1();
-	if(_arduinoID == 2) return verify2();
-	if(_arduinoID == 3) return verify3();
-}
-
-/// This function initializes the board, to make it ready for operations
-/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
-///
-void Crane::update()
-{
-	//-------------------------------- Divert the 'update()' to the arduinos specific "update()" functions
-	if(_arduinoID == 1) update1();
-	if(_arduinoID == 2) update2();
-	if(_arduinoID == 3) update3();
-}
-
-/// This function initializes the board, to make it ready for operations
-/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
-///
-int Crane::init()
-{
-	//-------------------------------- Divert the 'init()' to the arduinos specific "init()" functions
-	if(devMode) Serial.println("------------- Initializing board");
-	if(_arduinoID == 1) init1();
-	if(_arduinoID == 2) init2();
-	if(_arduinoID == 3) init3();
-}
-
-/// Read the HC-06 buffer, if there is anything at all
-/// Returns the incoming HC-06 message as a string (data read as char)
-///
-String Crane::returnHC06Msg()
-{
-	//-------------------------------- Declare return string
-	String ret = "";
-	
-	//-------------------------------- Is there anything in the buffer?
-	if (hcSerial.available()) {
-	
-	//-------------------------------- Read anything until the buffer is empty
-		while(hcSerial.available()) 
-		{ 
-	//-------------------------------- Add the incoming byte as a char to the return string
-			ret += (char)hcSerial.read();
-		}   
-	  Serial.println("Blo tand: " + ret);
-	}
-	
-	//-------------------------------- Return the return string
-	return ret;
-}
-
-/// This function is called everytime something is received over the I2C bus (it must be the first thing called in the implementation)
-/// It returns a string of the received data (as an array of chars)
-/// 
-String Crane::onReceive(int bytes)
-{
-	
-	if(devMode) Serial.print("Receiving Something: ");
-	
-	//-------------------------------- Declare return string
-	String in = "";
-	
-	//-------------------------------- Add all incoming bytes onto the return string (as char)
-	while(Wire.available())
-	{
-		in += (char)Wire.read();
-	}
-	
-	if(devMode) Serial.println(in);
-	
-	//-------------------------------- If the incoming message is a ping call, add "OK2" (Arduino 2) or "OK3" (Arduino 3) to the instruction buffer and subscribe the message
-	if(in == "Ping")
-	{ if(_arduinoID == 2) { addToBuffer("OK2"); subscribe(bufferLength -1); } else { addToBuffer("OK3"); subscribe(bufferLength -1);} }
-	
-	//-------------------------------- If the incoming message is "OK2" or "OK3", then set the respective verified flag to true.
-	else if(in == "OK2") { arduino2Verify = true; digitalWrite(10,HIGH);} else if(in == "OK3") { arduino3Verify = true; arduino2Verify = true; digitalWrite(11,HIGH);}
-	
-	//-------------------------------- If the incoming message is "VerifyOK", the board has been verified successfully.
-	else if(in == "VerifyOK") boardVerified = true;
-	
-	//-------------------------------- If the incoming message is "CONNECTED", set the blueConnected flag to true
-	if(in == "CONNECTED")	blueConnected = true;
-	
-	//-------------------------------- If the incoming message is "blueOK", set blueState to 1
-	if(in == "blueOK")
-		blueState = 1;
-	
-	//-------------------------------- If the incoming message is "blueERR", set blueState to 2
-	else if(in == "blueERR")
-		blueState = 2;
-	
-	//-------------------------------- if the incoming message is "blueINOP", set blueState to 3
-	else if(in == "blueINOP")
-		blueState = 3;
-	
-	
-	//-------------------------------- Return the incoming string for external processing
-	return in; 
-	
-}
-
-/// Subscribes an index
-/// This is used to flag indexes that have to be sent at a later time
-///
-void Crane::subscribe(uint8_t index)
-{
-	//-------------------------------- Subscribe the index: Set the value at index 'index' to true
-	subscribed[index] = true;
-	if(devMode) { Serial.print("Subscribing index "); Serial.println(index); }
-}
-
-/// Sends a byte of data over the I2C bus
-/// 
-///
-void Crane::sendData(uint8_t arduino, byte data)
-{
-	if(devMode) { Serial.print("Sending \""); Serial.print(data); Serial.print("\" To arduino "); Serial.println(arduino); }
-	
-	//-------------------------------- Begin transmission to address 'arduino', and send the data
-	Wire.beginTransmission(arduino);
-	Wire.write(data);
-	Wire.endTransmission(); 
-}
-
-/// Sends a string over the I2C bus
-/// This is done by sequentially sending each byte in the string
-///
-void Crane::sendData(uint8_t arduino, String data)
-{
-	if(devMode) { Serial.print("Sending \""); Serial.print(data); Serial.print("\" To arduino "); Serial.println(arduino); }
-	
-	//-------------------------------- Begin transmission to address 'arduino', and sequentially send the data in 'data'
-	Wire.beginTransmission(arduino);
-	for(byte b : data)
-	{
-		Wire.write(b);
-	}
-	Wire.endTransmission();
-	
-}
-
-/// Removes 'n' amount of indexes from the instruction buffer
-/// Note: the data is still 'available', its just treated as if it does not exist
-///
-void Crane::removeNFromBuffer(uint8_t n)
-{
-	//-------------------------------- artificially reduce the amount of elements in the bufferLength and bufferIndex
-	bufferLength -= n;
-	bufferIndex -= n;
-}
-
-/// Return the latest entry in the buffer
-/// Does not remove the entry, just makes it invisible.
-///
-String Crane::readBuffer()
-{
-	//-------------------------------- Declare return string
-	String value = "";
-	
-	//-------------------------------- If the index is less than the length, the return value is the value at index 'bufferIndex', and increase it by 1.
-	if(bufferIndex < bufferLength)
-	{
-		value = _instrBuffer[bufferIndex++];
-		return value;
-	}
-	
-	//-------------------------------- If the index is higher than the length of the buffer (No data available), return "EMPTY"
-	else
-		return "EMPTY";
-}
-
-/// Returns the amount of available entries
-/// 
-///
-int Crane::available()
-{
-	//-------------------------------- If the buffer is overflowing, flush it.
-	if(bufferLength == 35 && bufferIndex == 34)
-		flushBuffer();
-	
-	//-------------------------------- If the index is equal to or higher than the length of the buffer, return 0
-	if(bufferLength <= bufferIndex+1)
-	{
-		return 0;
-	}
-	
-	//-------------------------------- If there is something available, return the difference between the length and the index
-	return bufferLength - bufferIndex;
-}
-
-/// Clears the buffer of everything
-/// 
-///
-void Crane::flushBuffer()
-{
-	bufferLength = 0;
-	bufferIndex = 0;
-}
-
-/// Adds an entry to the buffer
-/// 
-///
-void Crane::addToBuffer(String instruction)
-{
-
-	_instrBuffer[bufferLength++] = instruction;
-	if(devMode)
-	{ Serial.print("Adding \""); Serial.print(instruction); Serial.print("\" to the buffer at index "); Serial.print(bufferLength); Serial.print(". Current index is "); Serial.println(bufferIndex); }
-		
-}
-
-/// pushes subscribed elements to I2C address "arId"
-/// only checks for n amount of things on the buffer, not n amount of subscribed elements
-///
-void Crane::pushBuffer(uint8_t arId, uint8_t n)
-{
-	uint8_t x;
-	for(x = 0; x < n; x++)
-	{
-		if(!subscribed[x]) sendData(arId, readBuffer());
-	}
-}
-
-/// pushes all subscribed elements to I2C address "arId"
-/// 
-///
-void Crane::pushBuffer(uint8_t ardId)
-{
-	for(int x = 0; x < 16; x++)
-	{
-		if(subscribed[x]) sendData(ardId, readBuffer());
-		subscribed[x] = false;
-	}
-}
-
-
-
-
-
-
-/* FUNCTIONS ARDUINO 1
-*
-* init1(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-* update1(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-* verify1(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-*
-*/
-
-/// The init function for arduino 1
-/// Initializes the servo, sets pinModes, resets arduino 2
-///
-int Crane::init1()
-{
-	//-------------------------------- Set stepper relay high
-	pinMode(9,OUTPUT);		
-	digitalWrite(9,HIGH);
-	
-	//-------------------------------- Setting the pinModes
-	pinMode(10,OUTPUT);
-	pinMode(11,OUTPUT);
-	digitalWrite(10,HIGH);
-	digitalWrite(11,HIGH);
-	
-	pinMode(A6,OUTPUT);
-	pinMode(6,INPUT);
-	
-	pinMode(7,OUTPUT);
-	pinMode(8,INPUT);
-	
-	pinMode(A6,INPUT);
-	
-	pinMode(4,INPUT);
-	pinMode(5,INPUT);
-	
-	pinMode(12,OUTPUT);
-	
-	//-------------------------------- Begin the wire communications on the I2C bus
-	Wire.begin(1);
-	
-	//-------------------------------- Begin the Serial communications with the PC and HC06
-	Serial.begin(9600);
-	hcSerial.begin(9600);
-	
-	//-------------------------------- Send a "AT+VERSION" command to the HC06 
-	hcSerial.write("AT+VERSION");
-	blueState = -1;
-	
-	//-------------------------------- Reset speeds on arduino 2
-	sendData(2,"STEP1:0.00");
-	sendData(2,"STEP2:0.00");
-	sendData(2,"STEP3:0.00");
-	
-	//--------------------------------- Attach the servo on pin 12
-	grip.attach(12);
-	
-
-	
-	return 1; //Return 1, Success (unused)
-}
-
-/// The verify function for arduino 1
-/// pings arduino 2, arduino3, checks that the bluetooth module is valid.
-///
-int Crane::verify1()
-{
-	//-------------------------------- Resets the LEDS
-	digitalWrite(10,LOW);
-	digitalWrite(11,LOW);
-	
-	//-------------------------------- Pings arduino 2 and arduino 3
-	sendData(3,"Ping");
-	sendData(2,"Ping");
-	Serial.println("Before");
-	
-	//-------------------------------- Check for a response from the bluetooth module
-	String blueRespons = returnHC06Msg();
-	Serial.println("Bluetooth module response: " + blueRespons);
-	
-	//-------------------------------- Send arduino 3 the status of the bluetooth module
-	if(blueRespons == "OKlinvorV1.8" && blueState == -1)
-		{ sendData(3,"blueOK"); blueState = 1; }		//Bluetooth module is ok
-	
-	else if(blueRespons != "" && blueState == -1)
-		{ sendData(3,"blueERR"); blueState = 2; }		//Something was received, but not expected value. (Error)
-	
-	else if(blueRespons == "" && blueState == -1)
-		{ sendData(3,"blueINOP"); blueState = 3; }		//Nothing was received at all. The communications failed.
-	
-	
-	//-------------------------------- Wait for a ping response
-	delay(7750);
-	Serial.println("After");
-	
-	//-------------------------------- If one of the arduinos were not able to be verified, throw error.
-	if(!arduino2Verify || !arduino3Verify)
-	{ digitalWrite(10,LOW); digitalWrite(11,LOW); return -1;	}
-
-	//-------------------------------- Else, if both of the arduinos were able to be verified, send an OK response.
-	else if(arduino2Verify && arduino3Verify)
-	{
-		sendData(2,"VerifyOK"); sendData(3,"VerifyOK"); boardVerified = true;
-	}
-	
-	//-------------------------------- Update the status leds (Green led: successfully verified, Red led: Verification failed)
-	digitalWrite(10,LOW);
-	digitalWrite(11,LOW);
-	digitalWrite(boardVerified ? 10 : 11, HIGH);
-	delay(5000);
-	digitalWrite(boardVerified ? 10 : 11, LOW);
-	
-	grip.write(10);
-	delay(1000);
-	grip.write(160);
-	delay(1000);
-	grip.write(0);
-	digitalWrite(10,HIGH);
-}
-
-/// The update function for arduino 1
-/// gets the gripper height
-///
-void Crane::update1()
-{
-	//-------------------------------- Sends pulse to TRIG pin
-	digitalWrite(A6,HIGH);
-	delayMicroseconds(10);
-	digitalWrite(A6,LOW);
-	
-	//-------------------------------- Parses return
-	long duration = pulseIn(6,HIGH)  / 29 / 2;
-	Serial.print("X:");
-	Serial.print(duration);
-	Serial.println("cm");
-	
-}
-
-
-
-
-/* FUNCTIONS ARDUINO 2
-*
-* init2(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-* update2(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-* verify2(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-* 
-* setSpeedOf(uint8_t stepper, float rps): Sets the speed of stepper 'stepper' to 'rps' (in rotations per second). Returns 0
-* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
-*	-> rps: the speed of the stepper motor in rotations per second. Note: the sign of this parameter determines the direction of the movement 
-* 
-* LCM(float n1, float n2, float n3): Returns the LCM of three numbers (rounded up).
-* 	-> n1: an arbitrary number
-* 	-> n2: an arbitrary number
-*	-> n3: an arbitrary number
-*
-* maX(uint8_t a, uint8_t b): Returns a if a > b. otherwise returns b
-*	-> a: an arbitrary number
-*	-> b: an arbitrary number
-*
-* stepSync(): Steps all motors in a synchronized manner
-*
-* step(uint8_t stepper): Steps the specified stepper once
-* 	-> stepper: the stepper id
-*
-* step(uint8_t stepper, bool direction): Steps the specified stepper once in a specified direction
-* 	-> stepper: the stepper id
-*	-> direction: the direction the stepper step
-*
-*
-*/
-
-/// The init function for arduino 2
-/// pinModes, enable stepper motors
-///
-int Crane::init2()
-{
-	//-------------------------------- Begin serial and wire
-	Wire.begin(2);
-	Serial.begin(9600);
-	
-	//-------------------------------- pinModes
-	pinMode(2,OUTPUT); //Step 1
-	pinMode(3,OUTPUT); //Dir 1
-	pinMode(4,OUTPUT); //En 1 [AL]
-	
-	pinMode(5,OUTPUT); //Step 2
-	pinMode(6,OUTPUT); //Dir 2
-	pinMode(7,OUTPUT); //En 2 [AL]
-	
-	pinMode(8,OUTPUT); //Step 3
-	pinMode(9,OUTPUT); //Dir 3
-	pinMode(10,OUTPUT); //En 3 [AL]
-	
-	//-------------------------------- enable stepper drivers
-	digitalWrite(4,LOW);
-	digitalWrite(7,LOW);
-	digitalWrite(10,LOW);
-	
-	
-}
-
-/// The verify function for arduino 2
-/// Turns each stepper a certain speed
-/// Note: This will move the crane. Be sure to allow for this movement
-int Crane::verify2()
-{
-	//-------------------------------- Check each motor
-	setSpeedOf(1,1);
-	int mil = millis();
-	
-	//-------------------------------- Turn motor one both ways
-	while(millis() - mil < 1000)
-	{
-		step(1,true);
-		delayMicroseconds(250);
-	}
-	delay(500);
-	setSpeedOf(1,2);
-	mil = millis();
-	while(millis() - mil < 1000)
-	{
-		step(1,false);
-		delayMicroseconds(500);
-	}
-	
-	delay(500);
-	setSpeedOf(1,4);
-	mil = millis();
-	
-	//-------------------------------- Turn motor two both ways
-	while(millis() - mil < 1000)
-	{
-		step(2,true);
-		delayMicroseconds(750);
-	}
-	delay(500);
-	setSpeedOf(1,0.25);
-	mil = millis();
-	while(millis() - mil < 1000)
-	{
-		step(2,false);
-		delayMicroseconds(1000);
-	}
-	
-	delay(500);
-	setSpeedOf(1,0.5);
-	mil = millis();
-	
-	//-------------------------------- Turn motor three both ways
-	while(millis() - mil < 1000)
-	{
-		step(3,true);
-		delayMicroseconds(5000);
-	}
-	delay(500);
-	mil = millis();
-	while(millis() - mil < 1000)
-	{
-		step(3,false);
-		delayMicroseconds(2500);
-	}
-	
-	//-------------------------------- Resets the speeds of the motors
-	setSpeedOf(1,0);
-	setSpeedOf(2,0);
-	setSpeedOf(3,0);
-	
-	//-------------------------------- Wait one second, then reply to ping message
-	delay(1000);
-	Serial.println("--Buff");
-	pushBuffer(1);
-}
-
-/// The update function for arduino 2
-/// Empty
-/// 
-void Crane::update2(){}
-
-/// Sets the speed of each stepper motor
-/// This allows for synchronous movement of the stepper motors
-/// 
-double Crane::setSpeedOf(uint8_t stepper, float rps)
-{
-	//-------------------------------- gets the absolute RPS
-	float aRPS = rps < 0 ? -rps : rps;
-	
-	//-------------------------------- Sets the speed for the respective stepper
-	switch(stepper)
-	{
-		case 1:
-		if(aRPS > 0.02) delayStep1 = (5/aRPS); else delayStep1 = 250; //Calculate speeds
-		digitalWrite(3, rps > 0); //Set direction pin high or low
-		break;
-		case 2:
-		if(aRPS > 0.02) delayStep2 = (5/aRPS); else delayStep2 = 250; //Calculate speeds
-		digitalWrite(6, rps > 0); //Set direction pin high or low
-		break;
-		case 3:
-		if(aRPS > 0.02) delayStep3 = (5/aRPS); else delayStep3 = 250; //Calculate speeds
-		digitalWrite(9, rps > 0); //Set direction pin high or low
-		break;
-	}
-	//-------------------------------- Return 0. (WIP algorithm)
-	return 0;
-}
-
-/// Finds the 'lowest*' common multiple of 3 numbers.
-/// allows for synchronous movement of the stepper motors
-/// (* it actually doesnt. its a lazily written algorithm....... )
-int Crane::LCM(float n1, float n2, float n3)
-{
-	//-------------------------------- Declare the offset (unused)
-	int offset = 0;
-	
-	//-------------------------------- If stepper 1 is disabled, act as if it steps every 10 milliseconds to ease calculations
-	if(n1 == 250) { n1 = 10; offset = 0; }
-	
-	//-------------------------------- If stepper 2 is disabled, act as if it steps every 10 milliseconds to ease calculations
-	if(n2 == 250) { n2 = 10; offset = 0; }
-	
-	//-------------------------------- If stepper 3 is disabled, act as if it steps every 10 milliseconds to ease calculations
-	if(n3 == 250) { n3 = 10; offset = 0; }
-	
-	//-------------------------------- If the steppers each have the same step time, then return the value of stepper 1 (unless they are disabled)
-	if(n1 == n2 && n2 == n3)
-		if(n1 != 250) return ceil(n1); else return -1;
-	
-	//-------------------------------- If n1 == n2, then the LCM is just n1 * n3
-	if(n1 == n2)
-		return ceil(n1*n3) + offset;
-	
-	//-------------------------------- If n2 == n3, then the LCM is just n1 * n2
-	if(n2 == n3)
-		return ceil(n1*n2) + offset;
-	
-	//-------------------------------- If n1 == n3, then the LCM is just n1 * n2
-	if(n1 == n3)
-		return ceil(n1*n2) + offset;
-	
-	//-------------------------------- If none of the above apply, just bruteforce it
-	for(float n = 1; n < 16; n++)
-	{
-		if(n1 * n == n2 * n && n2 * n == n3 * n)
-		{
-			return ceil(n1 * n) + offset;
-		}
-	}
-	
-	//-------------------------------- if not even the bruteforce method worked, just multiply all three
-	return ceil(n1 * n2 * n3) + offset;
-}
-
-/// Returns a or b, whichever is highest
-/// 
-/// (For some reason, the standard max() function kept giving me compile errors, so i made this
-uint8_t Crane::maX(uint8_t a, uint8_t b)
-{
-	return a > b ? a : b;
-}
-
-/// Steps the motors synchronously
-/// This function must be called after eachother with little delay, or the movement will not be synchronous
-/// ^ For this reason, do not use delays anywhere else in your code. (unless you are delaying microseconds)
-void Crane::stepSync()
-{
-	//-------------------------------- calculate the LCM to ensure each stepper can step synchronously.
-	runTime = LCM(maX(delayStep1,1),maX(delayStep2,1),maX(delayStep3,1));
-	
-	
-	//-------------------------------- declare and initialize the lastx variables. This ensures at least one step.
-	int lastx1 = -delayStep1, lastx2 = -delayStep2, lastx3 = -delayStep3;
-	for(int x = 0; x < runTime; x++)
-	{
-		delay(1);
-		if(x - lastx1 == delayStep1 && delayStep1 != 250) //If a predefined of milliseconds have passed,
-		{step(1); lastx1 = x; }									//step motor one
-		if(x - lastx2 == delayStep2 && delayStep2 != 250) //If a predefined of milliseconds have passed,
-		{step(2); lastx2 = x; }									//step motor two
-		if(x - lastx3 == delayStep3 && delayStep3 != 250) //If a predefined of milliseconds have passed,
-		{step(3); lastx3 = x; }									//step motor three
-		
-	}
-}
-
-/// Step stepper 'stepper' once
-/// The 'stepper' parameter specifies which stepper to drive (1,2,3)
-/// 
-void Crane::step(uint8_t stepper)
-{
-	//-------------------------------- Pulse the respective stepper step pin
-	digitalWrite(2+(stepper-1)*3,HIGH);
-	delayMicroseconds(3);
-	digitalWrite(2+(stepper-1)*3,LOW);
-}
-
-/// Step stepper 'stepper' once, with direction 'direction'
-/// 
-/// 
-void Crane::step(uint8_t stepper, bool direction)
-{
-	//-------------------------------- set the respective stepper dir pin
-	digitalWrite(3+(stepper-1)*3,direction);
-	
-	//-------------------------------- Pulse the respective stepper step pin
-	digitalWrite(2+(stepper-1)*3,HIGH);
-	delayMicroseconds(3);
-	digitalWrite(2+(stepper-1)*3,LOW);
-}
-
-
-
-
-
-
-/* FUNCTIONS ARDUINO 3
-*
-* init3(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
-* update3(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
-* verify3(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
-*
-* createCustomChars(): Creates the custom characters for the LCD screen
-*
-*/
-
-
-
-/// The init function for arduino 3
-/// pinModes, Display splash screen
-///
-int Crane::init3()
-{
-	//-------------------------------- pinModes
-	pinMode(9,OUTPUT);
-	pinMode(10,OUTPUT);
-	pinMode(11,OUTPUT);
-	
-	//-------------------------------- initialize display
-	_lcd.begin(16,2);
-	_lcd.setCursor(0,0);
-	
-	//-------------------------------- verify the board
-	verify();
-	delay(2500);
-	
-	//-------------------------------- if not in dev mode, display company splash screen and death toll
-	if(!devMode)
-	{
-		String name = "CDGMD I1             ";
-		String comp = "CDGMD";
-		
-		//-------------------------------- Display company name
-		_lcd.clear();
-		_lcd.home();
-		_lcd.print(comp);
-		
-		//-------------------------------- Scroll construction name to the left
-		for(int x = 15; x != -1; x--)
-		{
-			_lcd.setCursor(0,1);
-			_lcd.print("                ");
-			_lcd.setCursor(x,1);
-			_lcd.print(name);
-			delay(250);
-		}
-		
-		//-------------------------------- Scroll construction name to the left
-		delay(2500);
-		for(int x = 0; x < name.length(); x++)
-		{
-			
-			_lcd.scrollDisplayLeft();
-			delay(250);
-		}
-		delay(1000);
-		
-		//-------------------------------- display death toll
-		_lcd.clear();
-		_lcd.home();
-		_lcd.write("In loving memory");
-		_lcd.setCursor(0,1);
-		_lcd.write("7 Arduinos");
-		delay(1500);
-		_lcd.setCursor(0,1);
-		_lcd.write("5 Drivers       ");
-		delay(1500);
-		_lcd.setCursor(0,1);
-		_lcd.write("Countless HC-06 ");
-		delay(1500);
-		
-	}else
-	{ _lcd.print("dev Mode"); delay(1500); }
-
-	//-------------------------------- Clear everything. This is to reset everything with the scrolling.
-	_lcd.begin(16,2);
-	_lcd.setCursor(0,0);
-	createCustomChars();
-	
-	
-}
-
-/// The update function for arduino 3
-/// Display the UI of the crane.
-/// Note: because the UI is on arduino 3, and the step functions are on arduino 2 and arduino 1 controls the step functions, ensure coordination of the UI elements between the arduinos
-void Crane::update3()
-{
-	//-------------------------------- Clear the display
-	_lcd.clear();
-	_lcd.setCursor(14,0);
-	
-	//-------------------------------- If bluetooth connected, just display the connected graphic
-	if(blueConnected)
-	{
-		_lcd.write(char(5));
-		_lcd.write(char(7));
-	}else
-	{
-	//-------------------------------- Just loop over the connection frames if bluetooth not connected
-		frameConnect++;
-		if(frameConnect == 4) frameConnect = 0;
-		switch(frameConnect)
-		{
-			case 0: _lcd.write(char(4)); break;
-			case 1: _lcd.write(char(5)); break;
-			case 2: _lcd.write(char(5)); _lcd.write(char(6)); break;
-			case 3: _lcd.write(char(5)); _lcd.write(char(7)); break;
-		}
-		digitalWrite(10,frameConnect == 0 || frameConnect == 2);
-	}
-	
-	//-------------------------------- Set the status LED (the higher the condition, the higher priority it has
-	
-	//-------------------------------- Set led to yellow if the voltage is lower than 10.75 volts
-	if(voltage < 10.75)
-	{
-		analogWrite(9,255);
-		analogWrite(11,84);
-		analogWrite(10,0);
-	}
-	
-	//-------------------------------- If bluetooth was not connected, halt the if-else braiding. The status LED was set earlier
-	else if(!blueConnected) {}
-	
-	//-------------------------------- If the crane is in standby, set LED to white
-	else if(statusString == "Standby" || statusString == "Cooling")
-	{
-		digitalWrite(9,HIGH);
-		digitalWrite(11,HIGH);
-		digitalWrite(10,HIGH);
-	}
-	
-	//-------------------------------- If the board was not verified, set LED to green
-	else if(!boardVerified)
-	{
-		digitalWrite(9,LOW);
-		digitalWrite(11,HIGH);
-		digitalWrite(10,LOW);
-	}
-
-	//-------------------------------- There is nothing to display, turn of status LED.
-	else 
-	{
-		digitalWrite(9,LOW);
-		digitalWrite(11,LOW);
-		digitalWrite(10,LOW);
-	}
-	
-	//-------------------------------- print battery graphic based on voltage level
-	_lcd.setCursor(0,0);
-	_lcd.write(char(floor(voltage*2)-20));
-	
-	//-------------------------------- print current law of operation
-	_lcd.setCursor(3,0);
-	if(law == 0x00)
-	{
-		_lcd.print("Direct");
-	} else if(law == 0x02)
-	{
-		_lcd.print("Prec.");
-	}
-	
-	//-------------------------------- print horizontal movement of crane
-	_lcd.setCursor(13,1);
-	if(stateX < -1) _lcd.print("<"); else if(stateX == -1) _lcd.print("("); else if(stateX == 0) _lcd.print("|"); else if(stateX == 1) _lcd.print(")"); else _lcd.print(">");
-	
-	//-------------------------------- print vertical movement of crane
-	_lcd.setCursor(15,1);
-	if(stateY < -1) _lcd.print("_"); else if(stateY == -1) _lcd.print(","); else if(stateY == 0) _lcd.print("-"); else if(stateY == 1) _lcd.print("'"); else _lcd.print("^");
-	
-	//-------------------------------- print the status string
-	_lcd.setCursor(0,1);
-	_lcd.print(statusString);
-	
-	
-	
-}
-
-/// The verify function for arduino 3
-/// Displays verification outcome, and test the LEDs
-/// 
-int Crane::verify3()
-{
-	
-	//-------------------------------- Display "Starting..."
-	_lcd.clear();
-	_lcd.home();
-	_lcd.write("Starting...");
-	digitalWrite(9,HIGH);
-	digitalWrite(10,HIGH);
-	digitalWrite(11,HIGH);
-	delay(400);
-	digitalWrite(9,LOW);
-	digitalWrite(10,LOW);
-	digitalWrite(11,LOW);
-	
-	//-------------------------------- While Arduinos 1 and 2 verify, display a line graphic.
-	for(int x = 0; x < 16; x++)
-	{ _lcd.setCursor(x,1); _lcd.write("-"); delay(600); if(x == 8) pushBuffer(1); }
-
-	//-------------------------------- Wait a bit more
-	delay(4500);
-	_lcd.clear();
-	_lcd.home();
-	
-	//-------------------------------- If the board has verified, show "I2C: PASS"
-	if(boardVerified) 
-	_lcd.write("I2C: PASS");
-	
-	//-------------------------------- if the board has not been verified, show "I2C: FAIL"
-	else
-	{ _lcd.write("I2C: FAIL"); statusString = "I2C Fail"; }
-
-	//-------------------------------- display HC06 Status
-	_lcd.setCursor(0,1);
-	if(blueState == 0)
-		_lcd.print("HC-06: --"); //Bluetooth neither confirmed working or fail
-	if(blueState == 1)
-		_lcd.print("HC-06: OK"); //Bluetooth confirmed working
-	if(blueState == 2)
-		_lcd.print("HC-06: ERR"); //Bluetooth legible, but not working properly
-	if(blueState == 3)
-		_lcd.print("HC-06: INOP"); //Bluetooth confirmed fail
-	
-	//-------------------------------- Cycle the RGB LED
-	delay(2000);
-	digitalWrite(9,HIGH);
-	digitalWrite(10,LOW);
-	digitalWrite(11,LOW);
-	delay(1000);
-	digitalWrite(9,LOW);
-	digitalWrite(10,HIGH);
-	digitalWrite(11,LOW);
-	delay(1000);
-	digitalWrite(9,LOW);
-	digitalWrite(10,LOW);
-	digitalWrite(11,HIGH);
-	delay(1000);
-	digitalWrite(9,LOW);
-	digitalWrite(10,LOW);
-	digitalWrite(11,LOW);
-	
-	
-	
-}
-
-/// Creates the custom characters for the LCD screen
-/// 
-/// Note: call this function only once!!
-void Crane::createCustomChars()
-{
-	//-------------------------------- declares the temporary variable
-	byte customChar[] = {0, 0, 0, 0, 0, 0, 0, 0};
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B01110;
-	customChar[1] = B10001;
-	customChar[2] = B10001;
-	customChar[3] = B10001;
-	customChar[4] = B10001;
-	customChar[5] = B10001;
-	customChar[6] = B10001;
-	customChar[7] = B11111;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(0,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B01110;
-	customChar[1] = B10001;
-	customChar[2] = B10001;
-	customChar[3] = B10001;
-	customChar[4] = B10001;
-	customChar[5] = B11111;
-	customChar[6] = B11111;
-	customChar[7] = B11111;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(1,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B01110;
-	customChar[1] = B10001;
-	customChar[2] = B10001;
-	customChar[3] = B11111;
-	customChar[4] = B11111;
-	customChar[5] = B11111;
-	customChar[6] = B11111;
-	customChar[7] = B11111;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(2,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B01110;
-	customChar[1] = B11111;
-	customChar[2] = B11111;
-	customChar[3] = B11111;
-	customChar[4] = B11111;
-	customChar[5] = B11111;
-	customChar[6] = B11111;
-	customChar[7] = B11111;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(3,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B00000;
-	customChar[1] = B00000;
-	customChar[2] = B00000;
-	customChar[3] = B00000;
-	customChar[4] = B00000;
-	customChar[5] = B00000;
-	customChar[6] = B00000;
-	customChar[7] = B01000;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(4,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B00000;
-	customChar[1] = B00000;
-	customChar[2] = B00000;
-	customChar[3] = B00000;
-	customChar[4] = B00000;
-	customChar[5] = B00000;
-	customChar[6] = B00010;
-	customChar[7] = B01010;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(5,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B00000;
-	customChar[1] = B00000;
-	customChar[2] = B00000;
-	customChar[3] = B00000;
-	customChar[4] = B00000;
-	customChar[5] = B10000;
-	customChar[6] = B10000;
-	customChar[7] = B10000;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(6,customChar);
-	delay(100);
-	
-	//-------------------------------- defines the graphic
-	customChar[0] = B00000;
-	customChar[1] = B00000;
-	customChar[2] = B00000;
-	customChar[3] = B00000;
-	customChar[4] = B00100;
-	customChar[5] = B10100;
-	customChar[6] = B10100;
-	customChar[7] = B10100;
-	
-	//-------------------------------- Output graphic to LCD
-	_lcd.createChar(7,customChar);
-	delay(100);
-  
-}
+/*
+***********************************************************************
+*					     ___ _____   _____ __  __ _____               *
+*					  / ____|  __ \ / ____|  \/  |  __ \              *
+*					 | |    | |  | | |  __| \  / | |  | |             *
+*					 | |    | |  | | | |_ | |\/| | |  | |             *
+*					 | |____| |__| | |__| | |  | | |__| |             *
+*					  \_____|_____/ \_____|_|  |_|_____/              *
+*					                                                  *
+***********************************************************************				                                     
+*
+*  Zuyd Crane Project
+*
+*  Copyright © 2022 Rafael de Bie
+*  Permission is hereby granted, free of charge, to any person obtaining a
+*  copy of this software and associated documentation files (the "Software"),
+*  to deal in the Software without restriction, including without limitation
+*  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*  and/or sell copies of the Software, and to permit persons to whom the
+*  Software is furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all copies or 
+*  substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*************************************************************************
+*
+* The API for this library:
+*
+*
+*
+* Crane(uint8_t arduinoID): Crane Constructor
+* 	-> arduinoID: the ID of the arduino (1,2,3)
+* 
+* verify(): Calls the arduinos respective verify function
+* 
+* update(): Calls the arduinos respective update function
+* 
+* init():   Calls the arduinos respective init function
+* 
+* returnHC06Msg(): Checks for a complete message from the HC-06. Returns it as a string, if any
+* 
+* feedHC06(uint8_t c): The HC-06 message parser: takes one byte, and returns CRANE_BT_LINE or CRANE_BT_FRAME when a message is complete
+* 	A frame whose CRC does not match is dropped, and the parser looks for the next sync byte in its bytes (fed again by pollHC06)
+* 	Text lines end at '\n' (or when the module goes quiet), binary frames are [CRANE_BT_SYNC][length][payload]. Uses a fixed buffer of CRANE_BT_BUFFER bytes
+* 
+* onBlueLine(CraneBlueHandler handler), onBlueFrame(CraneBlueHandler handler): Register the functions that handle complete lines and frames. update() calls them
+* 
+* joystickFrame(...): The frame handler of the joystick controller: applies joystick frames to stateX, stateY, law and buttons. Use: onBlueFrame(Crane::joystickFrame)
+* 
+* encodeJoystick(uint8_t* frame, CraneJoystick& sent, int8_t x, int8_t y, uint8_t law, uint8_t buttons): The controller side of the joystick frames. Static, so it runs on any host
+* 	A state frame (6 bytes on the wire) is sent when something changed, a hold frame (4 bytes) when nothing did. Every CRANE_JOY_REFRESH hold frames the state is sent again
+* 	-> frame: where to write the frame (CRANE_JOY_FRAME_MAX bytes), ready to be written to the HC-06 as is
+* 	-> sent: the last state sent. Starts zeroed, and is updated by every call
+* 	-> x, y: the axes (-4 to 3), law: the law of operation (0 to 3), buttons: bit n set if button n is pressed
+* 
+* decodeJoystick(const uint8_t* payload, uint8_t length, CraneJoystick& state): Reads a joystick frame (without CRANE_BT_SYNC and length) into 'state'. Returns false if it is rejected
+* 
+* queuedData(uint8_t arduino): Returns the amount of messages waiting to be sent to arduino 'arduino' (0: all). Every send* function queues its message; update() sends them
+* 
+* processTransmit(): Sends the queued messages that are due. Messages that are not acknowledged are retried, up to CRANE_TX_ATTEMPTS times
+* 
+* sendSpeed(uint8_t stepper, int16_t centiRps): Sets the speed of a stepper on arduino 2 (in 0.01 rotations per second). Sent by the next update(); a newer speed for the same stepper replaces a pending one
+* 
+* flushSpeeds(): Queues the pending speed commands for arduino 2 now, as one transaction
+* 
+* resetBusStats(), printBusStats(): Clear and print the I2C statistics (messages, bytes, throughput and latency of both directions). Only with CRANE_BUS_STATS
+* 
+* record(uint8_t type, uint8_t arg, int16_t value): Records a telemetry sample (one of the CRANE_TM_ types). Never waits. The hot paths record their devMode diagnostics this way, instead of printing them
+* 
+* processTelemetry(): Sends the recorded samples over Serial: one frame per telemetryInterval, and only when it fits the Serial buffer. Called by update(). Only with CRANE_TELEMETRY
+* 	Frame: [CRANE_TM_SYNC][count][count samples][CRC-8 over count and samples]. Sample: type, arg, time (uint16, millis), value (int16), little endian
+* 	Other text on Serial (init, verify) can be in between frames: a reader looks for CRANE_TM_SYNC, and only takes frames whose CRC matches
+* 
+* decodeTelemetry(const uint8_t* frame, uint8_t length, CraneSample* samples): Reads a telemetry frame. Static, so a host can use it to decode the Serial stream
+* 
+* onReceive(): Queues whatever was received over I2C. It should be the first thing called in the implementation (the Wire receive callback). Returns false if the queue was full
+* 	While the queue is full, the arduino does not acknowledge its I2C address (AVR: TWEA), so a sender gets a NACK and retries (processTransmit) instead of losing the message
+* 
+* processReceived(): Handles the queued messages: applies commands and valid frames, and adds everything else (text, or bytes sent with sendData) to the instruction buffer. Called by update()
+* 
+* subscribe(uint8_t index): Subscribes an index. Used to flag indicies which must be sent at a later time.
+* 	-> index: The index to be subscribed
+* 
+* sendData(uint8_t arduino, byte data): Sends a byte of data to arduino (read: address) 'arduino'.
+* 	-> arduino: the address of the arduino.
+* 	-> data: the byte to be sent
+* 	
+* sendData(uint8_t arduino, String data): Sends a string (as a sequence of bytes) to arduino (read: address) 'arduino'.
+* 	-> arduino: the address of the arduino.
+* 	-> data: the string to be sent
+* 
+* sendData(uint8_t arduino, const char* data), sendData(uint8_t arduino, const __FlashStringHelper* data): Same, for a string literal or an F("...") string. No String is made
+* 
+* sendData(uint8_t arduino, const uint8_t* data, uint8_t length), sendData(uint8_t arduino, const char* data, uint8_t length): Sends 'length' bytes straight from 'data'
+* 	-> arduino: the address of the arduino.
+* 	-> data: the bytes to be sent (up to CRANE_WIRE_BUFFER)
+* 	-> length: the amount of bytes
+* 
+* sendFrame(uint8_t arduino, uint8_t opcode, int32_t a, int32_t b): Sends a binary frame ([opcode][seq][payload][CRC-8]) to arduino (read: address) 'arduino'.
+* 	-> arduino: the address of the arduino.
+* 	-> opcode: one of the CRANE_OP_ constants
+* 	-> a, b: the payload fields of the opcode (unused fields are ignored)
+* 
+* encodeFrame(...), decodeFrame(...): Convert a frame to and from bytes. Static, so they can be used without a Crane object
+* 
+* parseCommand(const uint8_t* text, uint8_t length, ...): Translates a text command ("Ping", "STEP1:0.50", ...) into the opcode and payload of the equivalent frame
+* 
+* onCommand(uint8_t opcode, CraneCommand command): Registers an application command. Frames with this opcode (CRANE_OP_USER and up) are handed to 'command'
+* 	-> opcode: the application opcode
+* 	-> command: the function that handles the frame, or 0 to remove it
+* 
+* sendCommand(uint8_t arduino, uint8_t opcode, const uint8_t* payload, uint8_t length): Sends an application frame to arduino (read: address) 'arduino'.
+* 	-> payload, length: the payload of the frame (up to 29 bytes)
+* 
+* removeNFromBuffer(uint8_t n): removes the 'n' newest unread entries from the instruction buffer
+* 	-> n: the amount of instructions to remove
+* 	
+* readBuffer(): reads the oldest unread entry in the buffer, returns it, and removes it from the buffer
+* 
+* readBuffer(uint8_t* data, uint8_t size): copies the oldest unread entry into 'data', removes it from the buffer, and returns its length (0: empty)
+* 	-> data: where to copy the entry to
+* 	-> size: the amount of bytes 'data' can hold
+* 
+* available(): returns the amount of unread buffer entries
+* 
+* flushBuffer(): clears the buffer.
+* 
+* addToBuffer(String instruction): adds the instruction to the buffer. Returns false if it does not fit (longer than CRANE_SLOT_LEN, or the buffer is full)
+* 	-> instruction: the instruction to be added
+* 
+* addToBuffer(const uint8_t* data, uint8_t length): adds 'length' bytes (text or a binary frame) to the buffer. Returns false if it does not fit
+* 	-> data: the bytes to be added
+* 	-> length: the amount of bytes
+* 
+* pushBuffer(uint8_t ardId, uint8_t n): Pushes (sends) subscribed entries to arduino (read: address). Only checks the first 'n' unread entries
+* 	Entries are sent in batches, as many as fit in one I2C transaction: [CRANE_OP_BATCH][length][entry][length][entry]... the receiver splits them again
+* 	-> ardId: the arduino to push to
+* 	-> n: the amount of entries to check
+* 
+* pushBuffer(uint8_t ardId): Pushes (sends) all subscribed entries to arduino (read: address), batched.
+* 	-> ardId: the arduino to push to
+*
+*
+************************
+*
+*
+* init1(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+*
+* update1(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
+*
+* verify1(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead. Only starts the boot sequence, which continues in "update()"
+*
+* updateBoot(): Advances the boot sequence: waits for the peers (each with its own timeout), the bluetooth module and the gripper servo at the same time. called from update1()
+*
+* printBootTrace(): Prints when each phase of the boot sequence finished (see bootTrace). Printed by itself in devMode
+*
+* updateEcho(): Triggers the range sensor once every CRANE_ECHO_CYCLE_MS, and collects the echo. Never waits for the sensor. called from update1()
+*
+* echoTick(): Samples the echo pin, and times the echo. Called from the Timer2 interrupt, which only runs during a measurement
+* 	The receive interrupt of SoftwareSerial (the HC-06) keeps the interrupts off for the whole byte: about 1 ms at 9600 baud. A tick in that time
+* 	comes up to 1 ms late, and so would an edge it sees (about 170 mm). An edge seen by a tick more than CRANE_ECHO_LATE_US after the one
+* 	before throws the measurement away (counted in echoLate). While the HC-06 sends, fewer distances come in, but none is off by more than that
+*
+* latestDistance(unsigned long* time): Returns the latest valid distance in millimetres (0: none yet)
+* 	-> time: if given, set to when the distance was measured (millis)
+*
+* filteredDistance(int16_t* velocity): Returns the filtered distance in millimetres (0: none yet)
+* 	-> velocity: if given, set to the vertical velocity in millimetres per second
+*
+* filterSample(CraneFilter& filter, uint16_t mm, uint32_t ms): The distance filter: a rolling median of CRANE_MEDIAN_LEN samples, then an alpha-beta filter. Fixed point only
+* 	Static, so recorded samples can be replayed through it on any host. The range sensor runs every valid distance through it
+* 	-> filter: the state of the filter (starts zeroed)
+* 	-> mm: the sample, in millimetres
+* 	-> ms: when the sample was taken (millis)
+*
+*
+************************
+*
+*
+* init2(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+*
+* update2(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead. Hands queued segments to the step engine CRANE_LOOKAHEAD_MS before the running move decelerates
+*
+* verify2(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead. Only starts the self test, which continues in "update()"
+*
+* updateSelfTest(): Advances the stepper self test by one state, and reports the result to arduino 1 ("SELF2:xyz") when done. called from update2()
+* 	The test is a smoke test of the step engine and its timing: the steppers run open loop, so it cannot tell whether a motor turned
+* 
+* setSpeedOf(uint8_t stepper, float rps): Sets the speed of stepper 'stepper' to 'rps' (in rotations per second, rounded to 0.01). Returns the step period in milliseconds
+* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
+*	-> rps: the speed of the stepper motor in rotations per second. Note: the sign of this parameter determines the direction of the movement 
+* 
+* setCentiSpeedOf(uint8_t stepper, int16_t centiRps): Sets the speed of stepper 'stepper' using integer math only
+* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
+*	-> centiRps: the speed of the stepper motor in hundredths of rotations per second. The sign determines the direction, 0 disables the stepper
+* 
+* parseStepCommand(const String& in): Parses a "STEPn:x.xx" speed command without floats, and sets the speed. Returns false if 'in' is not a speed command
+* 	-> in: the received command
+* 
+* LCM(uint32_t a, uint32_t b): Returns the exact LCM of two periods, or 0 if it is longer than CRANE_SYNC_WINDOW
+* 	-> a: a period in microseconds
+* 	-> b: a period in microseconds
+*
+* maX(uint8_t a, uint8_t b): Returns a if a > b. otherwise returns b
+*	-> a: an arbitrary number
+*	-> b: an arbitrary number
+*
+* stepSync(): Steps all motors in a synchronized manner. Queues one chunk of movement on the step engine and returns immediately
+*
+* moveSteps(int32_t steps1, int32_t steps2, int32_t steps3, uint32_t duration): Queues a linear move on the step engine, it starts when the current move is done. Returns false if another move is already waiting
+* 	-> steps1: the amount of steps stepper 1 takes (the sign determines the direction)
+* 	-> steps2: the amount of steps stepper 2 takes (the sign determines the direction)
+*	-> steps3: the amount of steps stepper 3 takes (the sign determines the direction)
+*	-> duration: the duration of the move in microseconds
+*
+* stepTo(uint8_t stepper, double positionFrom, double positionTo): Moves a stepper with a trapezoidal or S-curve velocity profile. Returns false if another move is already waiting
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> positionFrom: the current position of the stepper, in rotations
+*	-> positionTo: the target position of the stepper, in rotations
+*
+* setLimitsOf(uint8_t stepper, float maxRps, float maxAccel, float maxJerk): Sets the motion limits of a stepper, used by stepTo. The first call for a stepper allocates its RAM ramp table (64 bytes, never freed). Returns false if there is no memory for it
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> maxRps: the cruise speed in rotations per second
+*	-> maxAccel: the maximum acceleration in rotations per second^2
+*	-> maxJerk: the maximum jerk in rotations per second^3. 0 gives a trapezoidal profile, anything else an S-curve
+*
+* queueMove(int32_t steps1, int32_t steps2, int32_t steps3, float rps): Queues a move in the look-ahead queue. Consecutive moves blend without stopping. Returns false if the queue is full
+* 	-> steps1: the amount of steps stepper 1 takes (the sign determines the direction)
+* 	-> steps2: the amount of steps stepper 2 takes (the sign determines the direction)
+*	-> steps3: the amount of steps stepper 3 takes (the sign determines the direction)
+*	-> rps: the cruise speed of the stepper with the most steps, in rotations per second (0: its maximum speed)
+*
+* queuedMoves(): Returns the amount of moves in the look-ahead queue
+*
+* moveTo(float x, float z): Queues a move of the trolley (CRANE_AXIS_X) and hoist (CRANE_AXIS_Z) to an absolute position. Returns false if the queue is full
+* 	-> x: the target position of the trolley, in millimetres
+* 	-> z: the target position of the hoist, in millimetres
+*
+* parseMoveCommand(const String& in): Parses a "MOVE:x,z" command (in millimetres) and queues the move. Returns false if 'in' is not a move command
+* 	-> in: the received command
+*
+* positionOf(uint8_t stepper): Returns the position of a stepper in steps, as counted by the step engine
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+*
+* setPositionOf(uint8_t stepper, int32_t steps): Overwrites the position of a stepper, e.g. after homing. Only call this while the stepper is not moving
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> steps: the new position in steps
+*
+* setStepsPerMm(uint8_t stepper, float stepsPerMm): Sets the calibration of a stepper
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> stepsPerMm: the amount of steps per millimetre of travel
+*
+* isMoving(): Returns true while the step engine is executing (or about to execute) a move
+*
+* stopSteppers(): Stops the step engine immediately, and empties the look-ahead queue
+*
+* startTicker(uint32_t hz): Starts the periodic tick of the step engine (Timer2 on AVR)
+* 	-> hz: the tick frequency (10 kHz - 40 kHz)
+*
+* tick(): Advances the step engine by one tick. Called from the timer interrupt
+*
+* step(uint8_t stepper): Steps the specified stepper once
+* 	-> stepper: the stepper id
+*
+* step(uint8_t stepper, bool direction): Steps the specified stepper once in a specified direction. Ignored while the step engine is moving
+* 	-> stepper: the stepper id
+*	-> direction: the direction the stepper step
+*
+* pulseSteps(uint8_t mask): Steps several steppers once, with a single pulse (grouped port writes on the ATmega328P)
+* 	-> mask: the steppers to step (bit 0: stepper 1, bit 1: stepper 2, bit 2: stepper 3)
+*
+* setDirections(uint8_t mask, uint8_t dir): Sets the direction pins of several steppers at once
+* 	-> mask: the steppers to set (bit 0: stepper 1, bit 1: stepper 2, bit 2: stepper 3)
+*	-> dir: the directions (bit set: forward)
+*
+*
+************************
+*
+*
+* init3(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+*
+* update3(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
+*
+* verify3(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
+*
+* createCustomChars(): Creates the custom characters for the LCD screen
+
+
+************************************************************************
+*/
+
+
+
+
+
+
+#include "Arduino.h"
+#include "Crane.h"
+#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include "Wire.h"
+#include "LiquidCrystal.h"
+#include "Stepper.h"
+#include "SoftwareSerial.h"
+#if defined(__AVR__)
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+#if defined(CRANE_FAST_GPIO)
+#include <util/delay.h>
+#endif
+ 
+using namespace std;
+
+//-------------------------------- The crane whose step engine is driven by the timer interrupt
+static Crane* _tickCrane = 0;
+
+//-------------------------------- The crane whose range sensor is sampled by the timer interrupt (arduino 1)
+static Crane* _echoCrane = 0;
+
+//-------------------------------- Orders the accesses to a slot shared with an interrupt around the index or flag that hands it over (the receive queue, the next move)
+//-------------------------------- On AVR, 8-bit loads and stores are atomic, so stopping the compiler from reordering them is enough
+#if defined(__AVR__)
+#define CRANE_FENCE() __asm__ __volatile__("" ::: "memory")
+#else
+#define CRANE_FENCE() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+//-------------------------------- Turns the acknowledge of the own I2C address on and off. While it is off, the other arduinos get a NACK, and retry (see processTransmit)
+//-------------------------------- On AVR, this is the TWEA bit of the TWI. TWINT is written as 0, so a TWI event that is waiting for its interrupt is not cleared
+#if !defined(CRANE_WIRE_ACK) && defined(__AVR__)
+#define CRANE_WIRE_ACK(arduino, on) do { if(on) TWCR = (TWCR & ~_BV(TWINT)) | _BV(TWEA); else TWCR &= ~(_BV(TWEA) | _BV(TWINT)); } while(0)
+#elif !defined(CRANE_WIRE_ACK)
+#define CRANE_WIRE_ACK(arduino, on) do {} while(0)											//Elsewhere, a full receive queue drops what it gets (receiveOverflows)
+#endif
+
+#if defined(__AVR__)
+/// The Timer2 compare interrupt
+/// Advances the step engine of the crane that started the ticker (arduino 2), or samples the range sensor (arduino 1)
+///
+ISR(TIMER2_COMPA_vect)
+{
+	if(_echoCrane) _echoCrane->echoTick();
+	else if(_tickCrane) _tickCrane->tick();
+}
+#endif
+
+/// The constructor of the crane class
+/// Doesnt do much, because the 'Constructing' happens at the 'init()'.
+///
+Crane::Crane(uint8_t arduinoID)
+{
+	//-------------------------------- Set own arduinoID to the parameter
+	_arduinoID = arduinoID;
+}
+
+/// This function initializes the board, to make it ready for operations
+/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
+///
+int Crane::verify()
+{
+	//-------------------------------- Divert the 'verify()' to the arduinos specific "verify()" functions
+	if(devMode) Serial.println("------------- Verifying board");
+	if(_arduinoID == 1) return verify1();
+	if(_arduinoID == 2) return verify2();
+	if(_arduinoID == 3) return verify3();
+}
+
+/// This function initializes the board, to make it ready for operations
+/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
+///
+void Crane::update()
+{
+	//-------------------------------- Handle everything that was received since the last update
+	processReceived();
+	
+	//-------------------------------- Divert the 'update()' to the arduinos specific "update()" functions
+	if(_arduinoID == 1) update1();
+	if(_arduinoID == 2) update2();
+	if(_arduinoID == 3) update3();
+	
+	//-------------------------------- Send the speed commands that were set during this update, and whatever else is queued
+	flushSpeeds();
+	processTransmit();
+	processTelemetry();
+}
+
+/// This function initializes the board, to make it ready for operations
+/// More specifically, the generic "init()" function calls "init1()", "init2()", "init3()" respective of the arduino ID
+///
+int Crane::init()
+{
+	//-------------------------------- Divert the 'init()' to the arduinos specific "init()" functions
+	if(devMode) Serial.println("------------- Initializing board");
+	if(_arduinoID == 1) init1();
+	if(_arduinoID == 2) init2();
+	if(_arduinoID == 3) init3();
+}
+
+/// Feeds one byte from the HC-06 into the message parser, and returns CRANE_BT_LINE or CRANE_BT_FRAME when it completes a message (0: not yet)
+/// Text lines end at '\n' ('\r' is ignored). Binary frames are [CRANE_BT_SYNC][length][length bytes, the last one the CRC-8 of the others]. The message stays in the buffer until the next byte
+/// A broken frame leaves its bytes to be fed again from the first sync byte in it (see resyncHC06): readHC06 feeds those before any new byte
+uint8_t Crane::feedHC06(uint8_t c)
+{
+	//-------------------------------- The previous message has been handled, start a new one
+	if(_btDone) { _btDone = false; _btLength = 0; }
+	
+	switch(_btState)
+	{
+		//-------------------------------- Frame: the length byte. A length that does not fit the buffer means the stream is out of sync (another sync byte starts over)
+		case 1:
+		if(c < 2 || c > CRANE_BT_BUFFER) { _btState = c == CRANE_BT_SYNC ? 1 : 0; blueOverflows++; return 0; }
+		_btExpected = c;
+		_btState = 2;
+		return 0;
+		
+		//-------------------------------- Frame: the payload. If its CRC does not match, look for the next frame in it
+		case 2:
+		_btBuffer[_btLength++] = c;
+		if(_btLength < _btExpected) return 0;
+		if(crc8(_btBuffer, _btLength - 1) != _btBuffer[_btLength - 1]) { blueOverflows++; resyncHC06(); return 0; }
+		_btState = 0;
+		_btDone = true;
+		return CRANE_BT_FRAME;
+		
+		//-------------------------------- A line that did not fit the buffer: skip the rest of it, unless a frame starts
+		case 3:
+		if(c == '\n') _btState = 0;
+		if(c == CRANE_BT_SYNC) _btState = 1;
+		return 0;
+	}
+	
+	//-------------------------------- Text: a sync byte begins a frame. Text before it has lost its delimiter, it is complete (like text followed by silence, see readHC06)
+	if(c == CRANE_BT_SYNC)
+	{
+		_btState = 1;
+		if(!_btLength) return 0;
+		_btDone = true;
+		return CRANE_BT_LINE;
+	}
+	if(c == '\r') return 0;
+	if(c == '\n')
+	{
+		if(!_btLength) return 0;
+		_btDone = true;
+		return CRANE_BT_LINE;
+	}
+	if(_btLength == CRANE_BT_BUFFER) { _btLength = 0; _btState = 3; blueOverflows++; return 0; }
+	_btBuffer[_btLength++] = c;
+	return 0;
+}
+
+/// Reads bytes from the HC-06 until a message is complete, and returns its type (0: no complete message yet)
+/// The parser keeps its state in between calls, so a message can arrive over several calls
+///
+uint8_t Crane::readHC06()
+{
+	while(true)
+	{
+		//-------------------------------- First the bytes of a broken frame that are fed again, then the new ones
+		while(_btReplay != _btReplayEnd || hcSerial.available())
+		{
+			uint8_t c;
+			if(_btReplay != _btReplayEnd) c = _btBuffer[_btReplay++];
+			else { _btLastByte = millis(); c = hcSerial.read(); }
+			uint8_t type = feedHC06(c);
+			if(type) return type;
+		}
+		
+		//-------------------------------- Once the module has gone quiet: text without a delimiter (such as the reply to an AT command) is complete
+		if(_btDone || millis() - _btLastByte <= CRANE_BT_GAP_MS) return 0;
+		if(_btState == 0 && _btLength) { _btDone = true; return CRANE_BT_LINE; }
+		
+		//-------------------------------- Half a frame is broken: look for the next frame in it. Each pass drops a sync byte, so this ends
+		if(_btState == 1 || _btState == 2) { blueOverflows++; resyncHC06(); continue; }
+		_btState = 0;
+		return 0;
+	}
+}
+
+/// Drops the frame being received, and has readHC06 feed its payload to the parser again from the first sync byte in it
+/// The start of a frame can be lost, so that its length takes in (part of) the next frame: this way that frame is still found. Works in place, in _btBuffer
+void Crane::resyncHC06()
+{
+	//-------------------------------- Bytes that were still waiting to be fed again go right after the payload (moving down: the parser never writes past what it read)
+	uint8_t pending = _btReplayEnd - _btReplay;
+	memmove(_btBuffer + _btLength, _btBuffer + _btReplay, pending);
+	
+	//-------------------------------- Feed again from the first sync byte of the payload (or only the pending bytes, if there is none)
+	uint8_t start = 0;
+	while(start < _btLength && _btBuffer[start] != CRANE_BT_SYNC) start++;
+	_btReplay = start;
+	_btReplayEnd = _btLength + pending;
+	_btLength = 0;
+	_btState = 0;
+}
+
+/// Handles every complete message from the HC-06 with the registered handlers (see onBlueLine, onBlueFrame). Called from update1()
+/// Without any handler, nothing is read here, so returnHC06Msg() keeps working
+///
+void Crane::pollHC06()
+{
+	if(!_btOnLine && !_btOnFrame) return;
+	uint8_t type;
+	while((type = readHC06()))
+	{
+		CraneBlueHandler handler = type == CRANE_BT_LINE ? _btOnLine : _btOnFrame;
+		if(handler) handler(*this, _btBuffer, _btLength);
+	}
+}
+
+/// Registers the function that handles each complete text line from the HC-06 (0: none)
+/// 
+///
+void Crane::onBlueLine(CraneBlueHandler handler)
+{
+	_btOnLine = handler;
+}
+
+/// Registers the function that handles each complete binary frame from the HC-06 (0: none)
+/// 
+///
+void Crane::onBlueFrame(CraneBlueHandler handler)
+{
+	_btOnFrame = handler;
+}
+
+/// Returns the next complete text message from the HC-06, or "" if there is none yet
+/// Frames read on the way are handed to the frame handler
+///
+String Crane::returnHC06Msg()
+{
+	uint8_t type;
+	while((type = readHC06()))
+	{
+		//-------------------------------- Copy the line out of the parser buffer
+		if(type == CRANE_BT_LINE)
+		{
+			String ret = "";
+			for(uint8_t i = 0; i < _btLength; i++) ret += (char)_btBuffer[i];
+			return ret;
+		}
+		if(_btOnFrame) _btOnFrame(*this, _btBuffer, _btLength);
+	}
+	return "";
+}
+
+/// Writes the next joystick frame for the controller state: a state frame if anything changed, a hold frame if nothing did
+/// Wire format: [CRANE_BT_SYNC][length][kind | seq][x: bits 0-2, y: bits 3-5, law: bits 6-7][buttons][CRC-8]. A hold frame only has [kind | seq][CRC-8]
+uint8_t Crane::encodeJoystick(uint8_t* frame, CraneJoystick& sent, int8_t x, int8_t y, uint8_t law, uint8_t buttons)
+{
+	//-------------------------------- Clamp the state to what fits in the frame
+	x = x < -4 ? -4 : x > 3 ? 3 : x;
+	y = y < -4 ? -4 : y > 3 ? 3 : y;
+	law &= 3;
+	bool changed = !sent.seq || x != sent.x || y != sent.y || law != sent.law || buttons != sent.buttons;
+	
+	frame[0] = CRANE_BT_SYNC;
+	
+	//-------------------------------- Nothing changed: confirm the state that was sent last
+	if(!changed && sent.holds < CRANE_JOY_REFRESH)
+	{
+		frame[1] = 2;
+		frame[2] = CRANE_JOY_HOLD | sent.seq;
+		frame[3] = crc8(frame + 2, 1);
+		sent.holds++;
+		return 4;
+	}
+	
+	//-------------------------------- A new state gets the next sequence number (1 to 63), a refresh keeps it
+	if(changed)
+	{
+		sent.seq = sent.seq % 63 + 1;
+		sent.x = x;
+		sent.y = y;
+		sent.law = law;
+		sent.buttons = buttons;
+	}
+	sent.holds = 0;
+	
+	frame[1] = 4;
+	frame[2] = CRANE_JOY_STATE | sent.seq;
+	frame[3] = (x & 7) | ((y & 7) << 3) | (law << 6);
+	frame[4] = buttons;
+	frame[5] = crc8(frame + 2, 3);
+	return 6;
+}
+
+/// Reads a joystick frame (the payload, as handed to the frame handler) into 'state'
+/// Returns false if the CRC does not match, the frame is not a joystick frame, or it holds a state that was never received
+bool Crane::decodeJoystick(const uint8_t* payload, uint8_t length, CraneJoystick& state)
+{
+	if(length < 2 || crc8(payload, length - 1) != payload[length - 1]) return false;
+	uint8_t kind = payload[0] & 0xC0;
+	uint8_t seq = payload[0] & 0x3F;
+	
+	//-------------------------------- Hold frame: only valid if it confirms the state we have
+	if(kind == CRANE_JOY_HOLD) return length == 2 && seq && seq == state.seq;
+	if(kind != CRANE_JOY_STATE || length != 4 || !seq) return false;
+	
+	//-------------------------------- State frame: unpack the axes (sign extended) and the law
+	state.x = (int8_t)(payload[1] << 5) >> 5;
+	state.y = (int8_t)((payload[1] >> 3) << 5) >> 5;
+	state.law = payload[1] >> 6;
+	state.buttons = payload[2];
+	state.seq = seq;
+	return true;
+}
+
+/// Applies a joystick frame from the HC-06 to stateX, stateY, law and buttons
+/// A CraneBlueHandler: register it with onBlueFrame(Crane::joystickFrame)
+///
+void Crane::joystickFrame(Crane& crane, const uint8_t* data, uint8_t length)
+{
+	if(!decodeJoystick(data, length, crane._joystick)) { crane.joystickErrors++; return; }
+	crane.stateX = crane._joystick.x;
+	crane.stateY = crane._joystick.y;
+	crane.law = crane._joystick.law;
+	crane.buttons = crane._joystick.buttons;
+	crane.joystickTime = millis();
+}
+
+#if CRANE_BUS_STATS
+/// Adds a message of 'bytes' bytes that took 'us' microseconds to the bus statistics
+/// Histogram bucket k counts the messages that took less than 128 << k microseconds (the last bucket: all the slower ones)
+static void craneRecord(CraneBusStats& stats, uint8_t bytes, uint32_t us)
+{
+	stats.messages++;
+	stats.bytes += bytes;
+	stats.micros += us;
+	if(us > stats.maxMicros) stats.maxMicros = us;
+	
+	uint8_t bucket = 0;
+	for(uint32_t limit = 128; us >= limit && bucket < CRANE_BUS_BUCKETS - 1; limit <<= 1) bucket++;
+	stats.histogram[bucket]++;
+}
+#endif
+
+/// Clears the bus statistics, and starts measuring again from now
+/// 
+///
+void Crane::resetBusStats()
+{
+#if CRANE_BUS_STATS
+	memset(&txStats, 0, sizeof(txStats));
+	memset(&rxStats, 0, sizeof(rxStats));
+	busStatsSince = millis();
+#endif
+}
+
+/// Prints the bus statistics to the serial monitor
+/// For each direction: messages, bytes, throughput (bytes per second since resetBusStats), average and worst latency, and the latency histogram
+void Crane::printBusStats()
+{
+#if CRANE_BUS_STATS
+	uint32_t elapsed = millis() - busStatsSince;
+	const CraneBusStats* stats[2] = { &txStats, &rxStats };
+	for(uint8_t d = 0; d < 2; d++)
+	{
+		Serial.print(d ? "I2C RX: " : "I2C TX: ");
+		Serial.print(stats[d]->messages); Serial.print(" msgs, ");
+		Serial.print(stats[d]->bytes); Serial.print(" bytes, ");
+		Serial.print(elapsed ? stats[d]->bytes * 1000.0 / elapsed : 0); Serial.print(" B/s, avg ");
+		Serial.print(stats[d]->messages ? stats[d]->micros / stats[d]->messages : 0); Serial.print(" us, max ");
+		Serial.print(stats[d]->maxMicros); Serial.print(" us, failed ");
+		Serial.print(stats[d]->failures); Serial.print(", histogram");
+		for(uint8_t k = 0; k < CRANE_BUS_BUCKETS; k++) { Serial.print(' '); Serial.print(stats[d]->histogram[k]); }
+		Serial.println();
+	}
+#endif
+}
+
+/// Records a telemetry sample into the ring, stamped with the current time
+/// Never waits and never prints: if the ring is full, the sample is counted in telemetryDropped. processTelemetry sends the samples later
+///
+void Crane::record(uint8_t type, uint8_t arg, int16_t value)
+{
+#if CRANE_TELEMETRY
+	if((uint8_t)(_tmHead - _tmTail) >= CRANE_TM_SLOTS) { telemetryDropped++; return; }
+	CraneSample& sample = _tmRing[_tmHead & (CRANE_TM_SLOTS - 1)];
+	sample.type = type;
+	sample.arg = arg;
+	sample.time = millis();
+	sample.value = value;
+	_tmHead++;
+#endif
+}
+
+/// Sends up to CRANE_TM_BATCH recorded samples over Serial as one frame, at most once per telemetryInterval
+/// The frame is only written if it fits the Serial transmit buffer, so this never waits for the UART (the samples stay in the ring until it does)
+/// Frame: [CRANE_TM_SYNC][count][count samples: type, arg, time (uint16), value (int16), little endian][CRC-8 over count and samples]
+void Crane::processTelemetry()
+{
+#if CRANE_TELEMETRY
+	uint8_t count = _tmHead - _tmTail;
+	if(!count || millis() - _tmLast < telemetryInterval) return;
+	if(count > CRANE_TM_BATCH) count = CRANE_TM_BATCH;
+	uint8_t length = 3 + 6 * count;
+	if(Serial.availableForWrite() < length) return;
+	
+	//-------------------------------- Build the frame on the stack
+	uint8_t frame[CRANE_TM_FRAME_MAX];
+	frame[0] = CRANE_TM_SYNC;
+	frame[1] = count;
+	uint8_t* p = frame + 2;
+	for(uint8_t i = 0; i < count; i++)
+	{
+		const CraneSample& sample = _tmRing[(_tmTail + i) & (CRANE_TM_SLOTS - 1)];
+		*p++ = sample.type;
+		*p++ = sample.arg;
+		*p++ = sample.time;
+		*p++ = sample.time >> 8;
+		*p++ = sample.value;
+		*p++ = (uint16_t)sample.value >> 8;
+	}
+	*p = crc8(frame + 1, length - 2);
+	
+	Serial.write(frame, length);
+	_tmTail += count;
+	_tmLast = millis();
+#endif
+}
+
+/// Reads a telemetry frame (as sent by processTelemetry) into 'samples', which must hold CRANE_TM_BATCH samples
+/// Returns the amount of samples, or 0 if the frame is malformed or the CRC does not match. Static, so a host can decode the Serial stream with it
+uint8_t Crane::decodeTelemetry(const uint8_t* frame, uint8_t length, CraneSample* samples)
+{
+	if(length < 3 || frame[0] != CRANE_TM_SYNC) return 0;
+	uint8_t count = frame[1];
+	if(!count || count > CRANE_TM_BATCH || length != 3 + 6 * count || crc8(frame + 1, length - 2) != frame[length - 1]) return 0;
+	
+	const uint8_t* p = frame + 2;
+	for(uint8_t i = 0; i < count; i++, p += 6)
+	{
+		samples[i].type = p[0];
+		samples[i].arg = p[1];
+		samples[i].time = p[2] | (p[3] << 8);
+		samples[i].value = (int16_t)(p[4] | (p[5] << 8));
+	}
+	return count;
+}
+
+/// This function is called everytime something is received over the I2C bus (it must be the first thing called in the implementation)
+/// It runs in the interrupt of the I2C bus, so it only copies the transmission into the receive queue. update() handles it later
+/// Returns false if the queue was full, and the transmission was dropped
+bool Crane::onReceive(int bytes)
+{
+	//-------------------------------- Read the transmission (at most one Wire buffer) into the free slot of the queue, or aside if the queue is full
+	uint8_t head = _rxHead;
+	bool full = (uint8_t)(head - _rxTail) == CRANE_RX_SLOTS;
+	CraneReceived& slot = _rxQueue[head & (CRANE_RX_SLOTS - 1)];
+	uint8_t spare[CRANE_WIRE_BUFFER];
+	uint8_t* data = full ? spare : slot.data;
+	uint8_t length = 0;
+	while(Wire.available())
+	{
+		uint8_t c = Wire.read();
+		if(length < CRANE_WIRE_BUFFER) data[length++] = c;
+	}
+	
+	//-------------------------------- Speed commands replace the pending speed of their stepper, so they never queue up behind each other
+	if(coalesceSpeeds(data, length)) return true;
+	
+	//-------------------------------- If the queue is full, drop the transmission
+	if(full) { receiveOverflows++; return false; }
+	
+#if CRANE_BUS_STATS
+	slot.time = micros();
+#endif
+	slot.length = length;
+	
+	//-------------------------------- Publish the slot: the data has to be written before the head moves
+	CRANE_FENCE();
+	_rxHead = head + 1;
+	
+	//-------------------------------- If that was the last free slot, refuse the next transmission, so its sender retries instead of losing it
+	if((uint8_t)(head + 1 - _rxTail) == CRANE_RX_SLOTS) CRANE_WIRE_ACK(_arduinoID, false);
+	return true;
+}
+
+/// Stores received speed commands in the speed slot of their stepper (arduino 2, from onReceive)
+/// Only transmissions that hold nothing but STEP frames (on their own, or as a batch that isBatch accepts) are taken. A newer speed replaces one that was not applied yet
+/// Returns true if it took the transmission. Anything else (an empty batch or a lone 0xFF included) goes to the receive queue
+bool Crane::coalesceSpeeds(const uint8_t* data, uint8_t length)
+{
+	if(_arduinoID != 2 || !length) return false;
+	bool batch = isBatch(data, length);
+	
+	//-------------------------------- First check that every message is a valid STEP frame (and that there is one at all), then store them (in order, so the last one wins)
+	uint8_t count = 0;
+	for(uint8_t pass = 0; pass < 2; pass++)
+	{
+		uint8_t i = batch ? 1 : 0;
+		while(i < length)
+		{
+			uint8_t size = batch ? data[i++] : length;
+			uint8_t opcode, seq;
+			int32_t stepper, centi;
+			if(i + size > length || !decodeFrame(data + i, size, opcode, seq, stepper, centi) || opcode != CRANE_OP_STEP || stepper < 1 || stepper > 3) return false;
+			if(pass) { _speedIn[stepper - 1] = centi; _speedInPending |= 1 << (stepper - 1); }
+			else count++;
+			i += size;
+		}
+		if(!count) return false;
+	}
+	return true;
+}
+
+/// Handles everything onReceive has queued, in the order it was received
+/// Called from update(). Commands are applied, other text is added to the instruction buffer
+///
+void Crane::processReceived()
+{
+	uint8_t tail = _rxTail;
+	bool handled = tail != _rxHead;
+	while(tail != _rxHead)
+	{
+		//-------------------------------- The slot is complete once the head has moved past it
+		CRANE_FENCE();
+		const CraneReceived& slot = _rxQueue[tail & (CRANE_RX_SLOTS - 1)];
+		
+		if(devMode) record(CRANE_TM_RECEIVED, 0, slot.length);
+#if CRANE_BUS_STATS
+		craneRecord(rxStats, slot.length, micros() - slot.time);
+#endif
+		
+		//-------------------------------- A single message is handled as it is (so is data that starts with CRANE_OP_BATCH, but is not a batch)
+		if(!isBatch(slot.data, slot.length)) onMessage(slot.data, slot.length);
+		
+		//-------------------------------- A batch ([CRANE_OP_BATCH][length][message][length][message]...) is split, and each message is handled in order
+		else for(uint8_t i = 1; i < slot.length && i + 1 + slot.data[i] <= slot.length; i += 1 + slot.data[i])
+			onMessage(slot.data + i + 1, slot.data[i]);
+		
+		//-------------------------------- Hand the slot back to onReceive: it has to be read before the tail moves
+		CRANE_FENCE();
+		_rxTail = ++tail;
+	}
+	
+	//-------------------------------- There is room again: acknowledge the other arduinos (unless onReceive filled the queue up again in the meantime)
+	if(handled)
+	{
+		noInterrupts();
+		if((uint8_t)(_rxHead - _rxTail) < CRANE_RX_SLOTS) CRANE_WIRE_ACK(_arduinoID, true);
+		interrupts();
+	}
+	
+	//-------------------------------- Apply the newest speed of each stepper that got a speed command (the slots are shared with onReceive)
+	if(_speedInPending)
+	{
+		noInterrupts();
+		uint8_t pending = _speedInPending;
+		int16_t centi[3] = { _speedIn[0], _speedIn[1], _speedIn[2] };
+		_speedInPending = 0;
+		interrupts();
+		for(uint8_t s = 0; s < 3; s++) if((pending >> s) & 1) setCentiSpeedOf(s + 1, centi[s]);
+	}
+}
+
+/// Waits 'ms' milliseconds, while handling received messages and sending queued ones
+/// Used where the other arduinos are expected to answer during a wait
+///
+void Crane::waitBus(unsigned long ms)
+{
+	unsigned long start = millis();
+	do { processTransmit(); processReceived(); } while(millis() - start < ms);
+}
+
+/// Checks whether a transmission is a batch: CRANE_OP_BATCH, then length prefixed messages that end exactly at its end
+///
+bool Crane::isBatch(const uint8_t* data, uint8_t length)
+{
+	if(length < 2 || data[0] != CRANE_OP_BATCH) return false;
+	uint16_t i = 1;
+	while(i < length) i += 1 + data[i];
+	return i == length;
+}
+
+/// Handles a single message, received on its own or as part of a batch
+/// Frames and text commands are applied straight away. Anything else is added to the instruction buffer for the sketch (see readBuffer)
+/// A message is only a frame if its length and CRC check out: data that merely starts with a byte of 128 or more (sendData(arduino, byte)) is data
+void Crane::onMessage(const uint8_t* data, uint8_t length)
+{
+	uint8_t opcode, seq;
+	int32_t a, b;
+	
+	//-------------------------------- Application commands: [opcode][seq][payload][CRC-8], handed to the registered command as they are
+	if(length >= 3 && data[0] >= CRANE_OP_USER && data[0] < CRANE_OP_USER + CRANE_USER_COMMANDS && crc8(data, length - 1) == data[length - 1])
+	{
+		CraneCommand command = _commands[data[0] - CRANE_OP_USER];
+		if(command) command(*this, data + 2, length - 3);
+		else if(devMode) record(CRANE_TM_DROPPED, 0, 0);
+		return;
+	}
+	
+	//-------------------------------- A valid frame is decoded and applied
+	if(decodeFrame(data, length, opcode, seq, a, b)) { onFrame(opcode, a, b); return; }
+	
+	//-------------------------------- A text command is translated in place into the fields of the equivalent frame, and applied the same way
+	if(parseCommand(data, length, opcode, a, b)) { onFrame(opcode, a, b); return; }
+	
+	//-------------------------------- Anything else is left for the sketch
+	if(!addToBuffer(data, length) && devMode) record(CRANE_TM_DROPPED, 2, 0);
+}
+
+/// Subscribes an index
+/// This is used to flag indexes that have to be sent at a later time
+///
+void Crane::subscribe(uint8_t index)
+{
+	//-------------------------------- Subscribe the index: Set the value at index 'index' to true
+	subscribed |= (CraneSlotMask)1 << (index & (CRANE_BUFFER_SLOTS - 1));
+	if(devMode) record(CRANE_TM_SUBSCRIBE, 0, index);
+}
+
+/// Sends bytes to I2C address "arduino" in one transaction, and returns the status of Wire.endTransmission (0: success)
+/// Every message leaves through here (from processTransmit), so this is where the transmit statistics are kept
+///
+uint8_t Crane::transmit(uint8_t arduino, const uint8_t* data, uint8_t length)
+{
+#if CRANE_BUS_STATS
+	uint32_t start = micros();
+#endif
+	Wire.beginTransmission(arduino);
+	Wire.write(data, length);
+	uint8_t status = Wire.endTransmission();
+	
+	//-------------------------------- The Wire library acknowledges again after sending: keep refusing while the receive queue is full
+	if((uint8_t)(_rxHead - _rxTail) == CRANE_RX_SLOTS) CRANE_WIRE_ACK(_arduinoID, false);
+	
+#if CRANE_BUS_STATS
+	craneRecord(txStats, length, micros() - start);
+	if(status) txStats.failures++;
+#endif
+	return status;
+}
+
+/// Queues bytes for I2C address "arduino". They are sent by processTransmit (from update())
+/// If the queue is full, this waits until it has room (backpressure), so nothing is lost. Check queuedData() first to avoid waiting
+///
+void Crane::queueTransmit(uint8_t arduino, const uint8_t* data, uint8_t length)
+{
+	if(length > CRANE_WIRE_BUFFER) length = CRANE_WIRE_BUFFER;
+	
+	//-------------------------------- Find a free slot. If there is none, send until one frees up
+	CraneOutgoing* out = 0;
+	while(!out)
+	{
+		for(uint8_t i = 0; i < CRANE_TX_SLOTS && !out; i++) if(!_txQueue[i].arduino) out = &_txQueue[i];
+		if(!out) processTransmit();
+	}
+	
+	//-------------------------------- Fill the slot. It can be sent right away
+	out->arduino = arduino;
+	out->length = length;
+	out->attempts = 0;
+	out->order = _txOrder++;
+	out->retryAt = millis();
+	memcpy(out->data, data, length);
+}
+
+/// Sends the queued messages that are due, the oldest message of each destination first
+/// A message that is not acknowledged is tried again CRANE_TX_RETRY_MS later, up to CRANE_TX_ATTEMPTS times in total. Called from update()
+void Crane::processTransmit()
+{
+	uint16_t now = millis();
+	for(uint8_t i = 0; i < CRANE_TX_SLOTS; i++)
+	{
+		CraneOutgoing& out = _txQueue[i];
+		if(!out.arduino || (int16_t)(now - out.retryAt) < 0) continue;
+		
+		//-------------------------------- Only the oldest message of each destination may go, so the messages arrive in order
+		bool oldest = true;
+		for(uint8_t j = 0; j < CRANE_TX_SLOTS && oldest; j++)
+			if(_txQueue[j].arduino == out.arduino && (uint8_t)(_txOrder - _txQueue[j].order) > (uint8_t)(_txOrder - out.order)) oldest = false;
+		if(!oldest) continue;
+		
+		//-------------------------------- Send it. If it arrived, free the slot
+		uint8_t status = transmit(out.arduino, out.data, out.length);
+		if(!status) { out.arduino = 0; continue; }
+		
+		//-------------------------------- If it was not acknowledged, try again later. Give up after CRANE_TX_ATTEMPTS (or right away if it is too long for Wire)
+		if(status == 1 || ++out.attempts >= CRANE_TX_ATTEMPTS)
+		{
+			if(devMode) record(CRANE_TM_GAVE_UP, out.arduino, 0);
+			out.arduino = 0;
+			transmitFailures++;
+			continue;
+		}
+		out.retryAt = now + CRANE_TX_RETRY_MS;
+	}
+}
+
+/// Returns the amount of messages waiting to be sent to I2C address "arduino" (0: to any address)
+/// 
+///
+uint8_t Crane::queuedData(uint8_t arduino)
+{
+	uint8_t count = 0;
+	for(uint8_t i = 0; i < CRANE_TX_SLOTS; i++) if(_txQueue[i].arduino && (!arduino || _txQueue[i].arduino == arduino)) count++;
+	return count;
+}
+
+/// Sends a byte of data over the I2C bus
+/// 
+///
+void Crane::sendData(uint8_t arduino, byte data)
+{
+	if(devMode) record(CRANE_TM_SEND, arduino, 1);
+	
+	//-------------------------------- Send the data to address 'arduino'
+	queueTransmit(arduino, &data, 1);
+}
+
+/// Sends a block of bytes over the I2C bus
+/// The bytes are queued, and sent by update(). At most one Wire buffer (CRANE_WIRE_BUFFER bytes) is sent; the rest is cut off
+///
+void Crane::sendData(uint8_t arduino, const uint8_t* data, uint8_t length)
+{
+	if(length > CRANE_WIRE_BUFFER) length = CRANE_WIRE_BUFFER;
+	if(devMode) record(CRANE_TM_SEND, arduino, length);
+	
+	//-------------------------------- Queue the bytes for address 'arduino'. The caller's buffer can be reused right away
+	queueTransmit(arduino, data, length);
+}
+
+/// Sends 'length' characters over the I2C bus
+/// 
+///
+void Crane::sendData(uint8_t arduino, const char* data, uint8_t length)
+{
+	sendData(arduino, (const uint8_t*)data, length);
+}
+
+/// Sends a (null terminated) string over the I2C bus
+/// String literals go through here, so they are never turned into a String first
+///
+void Crane::sendData(uint8_t arduino, const char* data)
+{
+	size_t length = strlen(data);
+	sendData(arduino, (const uint8_t*)data, length > CRANE_WIRE_BUFFER ? CRANE_WIRE_BUFFER : length);
+}
+
+/// Sends a string stored in flash (F("...")) over the I2C bus
+/// Wire can only send from RAM, so the string is copied onto the stack first (at most one Wire buffer)
+///
+void Crane::sendData(uint8_t arduino, const __FlashStringHelper* data)
+{
+	uint8_t buffer[CRANE_WIRE_BUFFER];
+	size_t length = strlen_P((PGM_P)data);
+	if(length > CRANE_WIRE_BUFFER) length = CRANE_WIRE_BUFFER;
+	memcpy_P(buffer, data, length);
+	sendData(arduino, buffer, length);
+}
+
+/// Sends a string over the I2C bus
+/// The bytes of the string are sent in one transaction
+///
+void Crane::sendData(uint8_t arduino, const String& data)
+{
+	sendData(arduino, (const uint8_t*)data.c_str(), data.length() > CRANE_WIRE_BUFFER ? CRANE_WIRE_BUFFER : data.length());
+}
+
+/// Sets the speed of a stepper on arduino 2, in hundredths of rotations per second
+/// The command is sent by the next update() (or flushSpeeds). Until then, a newer speed for the same stepper replaces it
+///
+void Crane::sendSpeed(uint8_t stepper, int16_t centiRps)
+{
+	if(stepper < 1 || stepper > 3) return;
+	_speedOut[stepper - 1] = centiRps;
+	_speedOutPending |= 1 << (stepper - 1);
+}
+
+/// Queues the pending speed commands for arduino 2
+/// All of them go in one transaction (a batch of STEP frames)
+///
+void Crane::flushSpeeds()
+{
+	if(!_speedOutPending) return;
+	
+	//-------------------------------- Build the batch: [CRANE_OP_BATCH][length][STEP frame]... (three frames always fit)
+	uint8_t batch[CRANE_WIRE_BUFFER];
+	uint8_t length = 1, count = 0;
+	batch[0] = CRANE_OP_BATCH;
+	for(uint8_t s = 0; s < 3; s++)
+	{
+		if(!((_speedOutPending >> s) & 1)) continue;
+		uint8_t size = encodeFrame(batch + length + 1, CRANE_OP_STEP, _frameSeq++, s + 1, _speedOut[s]);
+		batch[length] = size;
+		length += 1 + size;
+		count++;
+	}
+	_speedOutPending = 0;
+	
+	sendBatch(2, batch, length, count);
+}
+
+/// Sends a binary frame over the I2C bus
+/// 'a' and 'b' are the payload fields of the opcode (see the CRANE_OP_ constants). Fields the opcode does not have are ignored
+///
+void Crane::sendFrame(uint8_t arduino, uint8_t opcode, int32_t a, int32_t b)
+{
+	//-------------------------------- Encode the frame on the stack. Unknown opcodes are not sent
+	uint8_t frame[CRANE_FRAME_MAX];
+	uint8_t length = encodeFrame(frame, opcode, _frameSeq, a, b);
+	if(!length) return;
+	_frameSeq++;
+	
+	if(devMode) record(CRANE_TM_FRAME, arduino, opcode);
+	
+	//-------------------------------- Send the whole frame in one go
+	queueTransmit(arduino, frame, length);
+}
+
+/// Returns the CRC-8 of a block of data
+/// Polynomial 0x07, initial value 0 (CRC-8/SMBUS)
+///
+uint8_t Crane::crc8(const uint8_t* data, uint8_t length)
+{
+	uint8_t crc = 0;
+	while(length--)
+	{
+		crc ^= *data++;
+		for(uint8_t b = 0; b < 8; b++) crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+	}
+	return crc;
+}
+
+//-------------------------------- The payload length of each opcode, in bytes (index: opcode - CRANE_OP_PING)
+//-------------------------------- 0: no payload, 1: a (uint8), 3: a (uint8) and b (int16), 8: a (int32) and b (int32)
+static const uint8_t _framePayloads[CRANE_OP_COUNT] PROGMEM = { 0, 1, 0, 0, 1, 3, 8, 1 };
+
+/// Returns the payload length of an opcode
+/// Returns 0xFF if the opcode is unknown
+///
+uint8_t Crane::framePayload(uint8_t opcode)
+{
+	if(opcode < CRANE_OP_PING || opcode >= CRANE_OP_PING + CRANE_OP_COUNT) return 0xFF;
+	return pgm_read_byte(&_framePayloads[opcode - CRANE_OP_PING]);
+}
+
+/// Encodes a binary frame: [opcode][seq][payload, little endian][CRC-8]
+/// Returns the length of the frame, or 0 if the opcode is unknown
+///
+uint8_t Crane::encodeFrame(uint8_t* frame, uint8_t opcode, uint8_t seq, int32_t a, int32_t b)
+{
+	uint8_t payload = framePayload(opcode);
+	if(payload == 0xFF) return 0;
+	
+	//-------------------------------- Header
+	frame[0] = opcode;
+	frame[1] = seq;
+	
+	//-------------------------------- Payload: field a first, then field b, both little endian
+	uint8_t widthA = payload == 8 ? 4 : payload ? 1 : 0;
+	uint8_t* p = frame + 2;
+	for(uint8_t i = 0; i < widthA; i++) *p++ = (uint32_t)a >> (8 * i);
+	for(uint8_t i = widthA; i < payload; i++) *p++ = (uint32_t)b >> (8 * (i - widthA));
+	
+	//-------------------------------- Checksum over the header and the payload
+	*p = crc8(frame, payload + 2);
+	return payload + 3;
+}
+
+/// Decodes a binary frame
+/// Returns false (and leaves the fields untouched) if the opcode is unknown, the length is wrong or the CRC does not match
+///
+bool Crane::decodeFrame(const uint8_t* frame, uint8_t length, uint8_t& opcode, uint8_t& seq, int32_t& a, int32_t& b)
+{
+	if(length < 3) return false;
+	uint8_t payload = framePayload(frame[0]);
+	if(payload == 0xFF || length != payload + 3 || crc8(frame, payload + 2) != frame[payload + 2]) return false;
+	
+	//-------------------------------- Read the fields back (little endian). The int16 field is sign extended
+	uint8_t widthA = payload == 8 ? 4 : payload ? 1 : 0;
+	uint32_t fieldA = 0, fieldB = 0;
+	for(uint8_t i = widthA; i > 0; i--) fieldA = (fieldA << 8) | frame[1 + i];
+	for(uint8_t i = payload; i > widthA; i--) fieldB = (fieldB << 8) | frame[1 + i];
+	
+	opcode = frame[0];
+	seq = frame[1];
+	a = (int32_t)fieldA;
+	b = payload == 3 ? (int16_t)fieldB : (int32_t)fieldB;
+	return true;
+}
+
+/// A text command that translates to a frame
+/// 
+struct CraneTextCommand
+{
+	char name[10];																	//The command (not null terminated if it is 10 characters long)
+	uint8_t length;																	//The length of the command. 0: empty entry
+	uint8_t opcode;																	//The opcode of the equivalent frame
+	uint8_t a;																		//Payload field a of the equivalent frame
+};
+
+//-------------------------------- The fixed text commands, stored at index (length + last character) % 16. This hash is perfect for this set of commands
+static const CraneTextCommand _textCommands[16] PROGMEM =
+{
+	{ "", 0, 0, 0 },
+	{ "blueOK", 6, CRANE_OP_BLUE, 1 },
+	{ "", 0, 0, 0 },
+	{ "VerifyOK", 8, CRANE_OP_VERIFY_OK, 0 },
+	{ "", 0, 0, 0 },
+	{ "OK2", 3, CRANE_OP_OK, 2 },
+	{ "OK3", 3, CRANE_OP_OK, 3 },
+	{ "", 0, 0, 0 },
+	{ "blueINOP", 8, CRANE_OP_BLUE, 3 },
+	{ "blueERR", 7, CRANE_OP_BLUE, 2 },
+	{ "", 0, 0, 0 },
+	{ "Ping", 4, CRANE_OP_PING, 0 },
+	{ "", 0, 0, 0 },
+	{ "CONNECTED", 9, CRANE_OP_CONNECTED, 0 },
+	{ "", 0, 0, 0 },
+	{ "", 0, 0, 0 },
+};
+
+/// Reads a signed decimal number from text, as an integer in units of 10^-decimals (extra decimals are cut off)
+/// 'p' is moved to the first character after the number. Returns false if there are no digits
+///
+static bool craneParseFixed(const uint8_t*& p, const uint8_t* end, uint8_t decimals, int32_t& value)
+{
+	//-------------------------------- Read the sign
+	bool negative = p < end && *p == '-';
+	if(p < end && (*p == '-' || *p == '+')) p++;
+	
+	//-------------------------------- Read the digits, and up to 'decimals' decimals
+	int32_t number = 0;
+	int8_t read = -1;
+	bool digits = false;
+	for(; p < end; p++)
+	{
+		if(*p == '.' && read < 0) { read = 0; continue; }
+		if(*p < '0' || *p > '9') break;
+		digits = true;
+		if(read < (int8_t)decimals) { number = number * 10 + (*p - '0'); if(read >= 0) read++; }
+	}
+	if(!digits) return false;
+	
+	//-------------------------------- Scale to the requested unit
+	if(read < 0) read = 0;
+	for(; read < (int8_t)decimals; read++) number *= 10;
+	value = negative ? -number : number;
+	return true;
+}
+
+/// Translates a text command into the opcode and payload fields of the equivalent frame, without copying it
+/// Fixed commands are found with one table lookup; "SELF2:xyz", "STEPn:x.xx" and "MOVE:x,z" are parsed. Returns false if the text is not a command
+bool Crane::parseCommand(const uint8_t* text, uint8_t length, uint8_t& opcode, int32_t& a, int32_t& b)
+{
+	if(!length) return false;
+	const uint8_t* end = text + length;
+	
+	//-------------------------------- "SELF2:xyz": the self test result of arduino 2 (P: passed, F: failed)
+	if(length == 9 && !memcmp(text, "SELF2:", 6))
+	{
+		opcode = CRANE_OP_SELF; a = 0; b = 0;
+		for(uint8_t s = 0; s < 3; s++) if(text[6+s] == 'P') a |= 1 << s;
+		return true;
+	}
+	
+	//-------------------------------- "STEPn:x.xx": speed of stepper n in rotations per second, to 0.01
+	if(length >= 7 && !memcmp(text, "STEP", 4) && text[5] == ':')
+	{
+		const uint8_t* p = text + 6;
+		if(!craneParseFixed(p, end, 2, b) || p != end || b > 32767 || b < -32768) return false;
+		opcode = CRANE_OP_STEP; a = text[4] - '0';
+		return true;
+	}
+	
+	//-------------------------------- "MOVE:x,z": a move to x, z in millimetres, to 0.01
+	if(length >= 8 && !memcmp(text, "MOVE:", 5))
+	{
+		const uint8_t* p = text + 5;
+		if(!craneParseFixed(p, end, 2, a) || p == end || *p++ != ',') return false;
+		if(!craneParseFixed(p, end, 2, b) || p != end) return false;
+		opcode = CRANE_OP_MOVE;
+		return true;
+	}
+	
+	//-------------------------------- Fixed commands: look up the only entry that can match, and compare it
+	const CraneTextCommand* entry = &_textCommands[(length + text[length - 1]) & 15];
+	if(pgm_read_byte(&entry->length) != length || memcmp_P(text, entry->name, length)) return false;
+	opcode = pgm_read_byte(&entry->opcode);
+	a = pgm_read_byte(&entry->a);
+	b = 0;
+	return true;
+}
+
+/// Registers the command of an application opcode (CRANE_OP_USER and up)
+/// Frames with this opcode are handed to 'command' with their payload. Pass 0 to remove the command. Returns false if the opcode is not an application opcode
+///
+bool Crane::onCommand(uint8_t opcode, CraneCommand command)
+{
+	if(opcode < CRANE_OP_USER || opcode >= CRANE_OP_USER + CRANE_USER_COMMANDS) return false;
+	_commands[opcode - CRANE_OP_USER] = command;
+	return true;
+}
+
+/// Sends an application frame over the I2C bus: [opcode][seq][payload][CRC-8]
+/// The payload can be up to CRANE_WIRE_BUFFER - 3 bytes long. Longer payloads, and opcodes that are not application opcodes, are not sent
+///
+void Crane::sendCommand(uint8_t arduino, uint8_t opcode, const uint8_t* payload, uint8_t length)
+{
+	if(opcode < CRANE_OP_USER || opcode >= CRANE_OP_USER + CRANE_USER_COMMANDS || length > CRANE_WIRE_BUFFER - 3) return;
+	
+	//-------------------------------- Build the frame on the stack, and send it in one go
+	uint8_t frame[CRANE_WIRE_BUFFER];
+	frame[0] = opcode;
+	frame[1] = _frameSeq++;
+	memcpy(frame + 2, payload, length);
+	frame[length + 2] = crc8(frame, length + 2);
+	
+	queueTransmit(arduino, frame, length + 3);
+}
+
+/// Applies a received binary frame
+/// Text commands are translated into frames first (see parseCommand), so this is the only place where commands are applied
+///
+void Crane::onFrame(uint8_t opcode, int32_t a, int32_t b)
+{
+	switch(opcode)
+	{
+		//-------------------------------- Ping: queue the reply frame of this arduino and subscribe it
+		case CRANE_OP_PING:
+		{
+			uint8_t frame[CRANE_FRAME_MAX];
+			if(addToBuffer(frame, encodeFrame(frame, CRANE_OP_OK, _frameSeq++, _arduinoID, 0))) subscribe(bufferLength -1);
+		}
+		break;
+		
+		//-------------------------------- Ping reply: set the respective verified flag
+		case CRANE_OP_OK:
+		if(a == 2) { arduino2Verify = true; digitalWrite(10,HIGH); } else if(a == 3) { arduino3Verify = true; digitalWrite(11,HIGH); }
+		break;
+		
+		case CRANE_OP_VERIFY_OK: boardVerified = true; break;
+		case CRANE_OP_CONNECTED: blueConnected = true; break;
+		case CRANE_OP_BLUE: blueState = a; break;
+		case CRANE_OP_SELF: stepperTest = a; break;
+		
+		//-------------------------------- Speed and move commands are applied by arduino 2 straight away
+		case CRANE_OP_STEP: if(_arduinoID == 2) setCentiSpeedOf(a, b); break;
+		case CRANE_OP_MOVE: if(_arduinoID == 2) moveTo(a / 100.0, b / 100.0); break;
+	}
+}
+
+/// Removes 'n' amount of entries from the instruction buffer
+/// The newest unread entries are removed first. Never removes more than available()
+///
+void Crane::removeNFromBuffer(uint8_t n)
+{
+	//-------------------------------- Drop entries from the end of the ring. Entries that were already pushed do not count
+	while(n && bufferLength != bufferIndex)
+	{
+		uint8_t slot = --bufferLength & (CRANE_BUFFER_SLOTS - 1);
+		if(_instrBuffer[slot].length) n--; else _bufferSent--;
+		subscribed &= ~((CraneSlotMask)1 << slot);
+	}
+}
+
+/// Moves the read counter past the entries at the front of the buffer that were already pushed
+/// 
+///
+void Crane::skipSent()
+{
+	while(bufferIndex != bufferLength && !_instrBuffer[bufferIndex & (CRANE_BUFFER_SLOTS - 1)].length) { bufferIndex++; _bufferSent--; }
+}
+
+/// Copies the first unread entry of the buffer into 'data', and removes it from the buffer
+/// Returns the length of the entry, or 0 if the buffer is empty. Entries longer than 'size' are cut off
+///
+uint8_t Crane::readBuffer(uint8_t* data, uint8_t size)
+{
+	skipSent();
+	if(bufferIndex == bufferLength) return 0;
+	
+	//-------------------------------- Copy the slot at 'bufferIndex', and advance the read counter
+	uint8_t slot = bufferIndex++ & (CRANE_BUFFER_SLOTS - 1);
+	uint8_t length = _instrBuffer[slot].length < size ? _instrBuffer[slot].length : size;
+	memcpy(data, _instrBuffer[slot].data, length);
+	subscribed &= ~((CraneSlotMask)1 << slot);
+	return length;
+}
+
+/// Return the first unread entry in the buffer, and removes it from the buffer
+/// Returns "EMPTY" if there is nothing to read
+///
+String Crane::readBuffer()
+{
+	//-------------------------------- Copy the entry into a (null terminated) character array
+	char value[CRANE_SLOT_LEN + 1];
+	uint8_t length = readBuffer((uint8_t*)value, CRANE_SLOT_LEN);
+	
+	//-------------------------------- If there was nothing available, return "EMPTY"
+	if(!length) return "EMPTY";
+	value[length] = 0;
+	return String(value);
+}
+
+/// Returns the amount of available entries
+/// 
+///
+int Crane::available()
+{
+	//-------------------------------- The counters wrap around together, so their difference is the amount of unread entries (minus the ones already pushed)
+	return (uint8_t)(bufferLength - bufferIndex) - _bufferSent;
+}
+
+/// Clears the buffer of everything
+/// 
+///
+void Crane::flushBuffer()
+{
+	bufferLength = 0;
+	bufferIndex = 0;
+	_bufferSent = 0;
+	subscribed = 0;
+}
+
+/// Adds an entry to the buffer
+/// Returns false if the entry is empty or longer than CRANE_SLOT_LEN, or if the buffer is full (unless CRANE_BUFFER_DROP_OLDEST is defined)
+///
+bool Crane::addToBuffer(const uint8_t* data, uint8_t length)
+{
+	if(!length || length > CRANE_SLOT_LEN) return false;
+	
+	//-------------------------------- If the buffer is full, either reject the entry or overwrite the oldest one
+	skipSent();
+	if((uint8_t)(bufferLength - bufferIndex) == CRANE_BUFFER_SLOTS)
+	{
+		bufferOverflows++;
+#ifdef CRANE_BUFFER_DROP_OLDEST
+		subscribed &= ~((CraneSlotMask)1 << (bufferIndex++ & (CRANE_BUFFER_SLOTS - 1)));
+		skipSent();
+#else
+		return false;
+#endif
+	}
+	
+	//-------------------------------- Copy the entry into the slot at 'bufferLength', and advance the write counter
+	uint8_t slot = bufferLength++ & (CRANE_BUFFER_SLOTS - 1);
+	memcpy(_instrBuffer[slot].data, data, length);
+	_instrBuffer[slot].length = length;
+	subscribed &= ~((CraneSlotMask)1 << slot);
+	
+	if(devMode) record(CRANE_TM_BUFFER, slot, length);
+	return true;
+}
+
+/// Adds a text entry to the buffer
+/// 
+///
+bool Crane::addToBuffer(const char* instruction)
+{
+	size_t length = strlen(instruction);
+	return length <= CRANE_SLOT_LEN && addToBuffer((const uint8_t*)instruction, length);
+}
+
+/// Adds a text entry to the buffer
+/// 
+///
+bool Crane::addToBuffer(const String& instruction)
+{
+	return addToBuffer(instruction.c_str());
+}
+
+/// Sends a batch of messages to I2C address "arduino" in one transaction
+/// A batch of a single message is sent without the batch header, exactly as the message was added
+///
+void Crane::sendBatch(uint8_t arduino, const uint8_t* batch, uint8_t length, uint8_t count)
+{
+	if(devMode) record(CRANE_TM_PUSH, arduino, count);
+	
+	if(count == 1) queueTransmit(arduino, batch + 2, length - 2);
+	else queueTransmit(arduino, batch, length);
+}
+
+/// pushes subscribed elements to I2C address "arId"
+/// only checks the first n unread entries of the buffer, not n amount of subscribed elements.
+/// As many entries as fit in the Wire buffer are sent per transaction, as a batch: [CRANE_OP_BATCH][length][entry][length][entry]...
+void Crane::pushBuffer(uint8_t arId, uint8_t n)
+{
+	uint8_t batch[CRANE_WIRE_BUFFER];
+	uint8_t length = 1, count = 0;
+	batch[0] = CRANE_OP_BATCH;
+	
+	for(uint8_t c = bufferIndex; c != bufferLength && n; c++)
+	{
+		//-------------------------------- Skip entries that were already pushed, and unsubscribed entries (those are read by the sketch)
+		uint8_t slot = c & (CRANE_BUFFER_SLOTS - 1);
+		CraneSlot& entry = _instrBuffer[slot];
+		if(!entry.length) continue;
+		n--;
+		if(!(subscribed & ((CraneSlotMask)1 << slot))) continue;
+		
+		//-------------------------------- If the entry does not fit in this transaction anymore, send the batch so far
+		if(length + 1 + entry.length > CRANE_WIRE_BUFFER) { sendBatch(arId, batch, length, count); length = 1; count = 0; }
+		
+		//-------------------------------- Append the entry (length prefixed) and mark it as pushed
+		batch[length++] = entry.length;
+		memcpy(batch + length, entry.data, entry.length);
+		length += entry.length;
+		count++;
+		entry.length = 0;
+		_bufferSent++;
+		subscribed &= ~((CraneSlotMask)1 << slot);
+	}
+	
+	if(count) sendBatch(arId, batch, length, count);
+	skipSent();
+}
+
+/// pushes all subscribed elements to I2C address "arId"
+/// 
+///
+void Crane::pushBuffer(uint8_t ardId)
+{
+	pushBuffer(ardId, CRANE_BUFFER_SLOTS);
+}
+
+
+
+
+
+
+/* FUNCTIONS ARDUINO 1
+*
+* init1(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+* update1(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
+* verify1(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead. Only starts the boot sequence, which continues in "update()"
+* updateBoot(): Advances the boot sequence by one step, and records when each phase finished. called from update1()
+* updateEcho(): Runs the range sensor: triggers it when it is due, and collects the echo timed by the Timer2 interrupt. called from update1()
+*
+*/
+
+/// The init function for arduino 1
+/// Initializes the servo, sets pinModes, resets arduino 2
+///
+int Crane::init1()
+{
+	//-------------------------------- Set stepper relay high
+	pinMode(9,OUTPUT);		
+	digitalWrite(9,HIGH);
+	
+	//-------------------------------- Setting the pinModes
+	pinMode(10,OUTPUT);
+	pinMode(11,OUTPUT);
+	digitalWrite(10,HIGH);
+	digitalWrite(11,HIGH);
+	
+	pinMode(A6,OUTPUT);
+	pinMode(6,INPUT);
+	
+	pinMode(7,OUTPUT);
+	pinMode(8,INPUT);
+	
+	pinMode(A6,INPUT);
+	
+	pinMode(4,INPUT);
+	pinMode(5,INPUT);
+	
+	pinMode(12,OUTPUT);
+	
+	//-------------------------------- Timer2 samples the echo pin of the range sensor: CTC mode, prescaler 8. Its interrupt only runs during a measurement (see updateEcho)
+	_echoCrane = this;
+#if defined(__AVR__)
+	noInterrupts();
+	TCCR2A = 1 << WGM21;
+	TCCR2B = 1 << CS21;
+	OCR2A = (F_CPU / 8) / CRANE_ECHO_TICK_HZ - 1;
+	interrupts();
+#endif
+	
+	//-------------------------------- Begin the wire communications on the I2C bus
+	Wire.begin(1);
+	
+	//-------------------------------- Begin the Serial communications with the PC and HC06
+	Serial.begin(9600);
+	hcSerial.begin(9600);
+	
+	//-------------------------------- Send a "AT+VERSION" command to the HC06 
+	hcSerial.write("AT+VERSION");
+	blueState = -1;
+	
+	//-------------------------------- Reset speeds on arduino 2
+	sendSpeed(1, 0);
+	sendSpeed(2, 0);
+	sendSpeed(3, 0);
+	flushSpeeds();
+	
+	//--------------------------------- Attach the servo on pin 12
+	grip.attach(12);
+	
+
+	
+	return 1; //Return 1, Success (unused)
+}
+
+/// The verify function for arduino 1
+/// Pings arduino 2 and arduino 3, and starts the boot sequence. Returns immediately: the sequence runs from update1(), and sets boardVerified once both peers replied
+/// The peers, the bluetooth module and the gripper servo are checked at the same time (see updateBoot)
+int Crane::verify1()
+{
+	//-------------------------------- Resets the LEDS
+	digitalWrite(10,LOW);
+	digitalWrite(11,LOW);
+	
+	//-------------------------------- Pings arduino 2 and arduino 3
+	sendFrame(3, CRANE_OP_PING);
+	sendFrame(2, CRANE_OP_PING);
+	
+	//-------------------------------- Start every phase at once (init1 already sent AT+VERSION to the bluetooth module), and move the gripper to its first position
+	_bootStart = millis();
+	bootPending = (1 << CRANE_BOOT_PHASES) - 1;
+	_bootServo = 0;
+	grip.write(10);
+	return 1;
+}
+
+/// Advances the boot sequence of arduino 1
+/// Each phase finishes as soon as its event comes in (or it times out), and its time is kept in bootTrace. Called from update1() until bootPending is 0
+///
+void Crane::updateBoot()
+{
+	unsigned long now = millis() - _bootStart;
+	
+	//-------------------------------- The peers: done as soon as their ping reply is in (see onFrame), or once they time out
+	if((bootPending & (1 << CRANE_BOOT_PEER2)) && (arduino2Verify || now >= CRANE_BOOT_TIMEOUT_2))
+		{ bootPending &= ~(1 << CRANE_BOOT_PEER2); bootTrace[CRANE_BOOT_PEER2] = now; }
+	if((bootPending & (1 << CRANE_BOOT_PEER3)) && (arduino3Verify || now >= CRANE_BOOT_TIMEOUT_3))
+		{ bootPending &= ~(1 << CRANE_BOOT_PEER3); bootTrace[CRANE_BOOT_PEER3] = now; }
+	
+	//-------------------------------- The bluetooth module: its reply has no delimiter, so it is complete once the module goes quiet
+	if(bootPending & (1 << CRANE_BOOT_BLUE))
+	{
+		String blueRespons = returnHC06Msg();
+		if(blueRespons != "" || now >= CRANE_BOOT_BLUE_MS)
+		{
+			Serial.println("Bluetooth module response: " + blueRespons);
+	
+			//-------------------------------- Send arduino 3 the status of the bluetooth module (1: ok, 2: unexpected reply, 3: no reply at all)
+			if(blueState == -1)
+			{
+				blueState = blueRespons == "OKlinvorV1.8" ? 1 : blueRespons != "" ? 2 : 3;
+				sendFrame(3, CRANE_OP_BLUE, blueState);
+			}
+			bootPending &= ~(1 << CRANE_BOOT_BLUE);
+			bootTrace[CRANE_BOOT_BLUE] = now;
+		}
+	}
+	
+	//-------------------------------- The gripper servo: 10, 160, then 0 degrees, CRANE_BOOT_SERVO_MS apart
+	if((bootPending & (1 << CRANE_BOOT_SERVO)) && now >= (_bootServo + 1) * (unsigned long)CRANE_BOOT_SERVO_MS)
+	{
+		grip.write(_bootServo++ ? 0 : 160);
+		if(_bootServo == 2) { bootPending &= ~(1 << CRANE_BOOT_SERVO); bootTrace[CRANE_BOOT_SERVO] = now; }
+	}
+	
+	//-------------------------------- Both peers are done: send the result, and show it on the status leds (Green led: successfully verified, Red led: Verification failed)
+	if((bootPending & (1 << CRANE_BOOT_RESULT)) && !(bootPending & ((1 << CRANE_BOOT_PEER2) | (1 << CRANE_BOOT_PEER3))))
+	{
+		if(arduino2Verify && arduino3Verify)
+			{ sendFrame(2, CRANE_OP_VERIFY_OK); sendFrame(3, CRANE_OP_VERIFY_OK); boardVerified = true; }
+		digitalWrite(10,LOW);
+		digitalWrite(11,LOW);
+		digitalWrite(boardVerified ? 10 : 11, HIGH);
+		bootPending &= ~(1 << CRANE_BOOT_RESULT);
+		bootTrace[CRANE_BOOT_RESULT] = now;
+	}
+	
+	//-------------------------------- Switch the status led off again after a while
+	if((bootPending & (1 << CRANE_BOOT_LED)) && !(bootPending & (1 << CRANE_BOOT_RESULT)) && now - bootTrace[CRANE_BOOT_RESULT] >= CRANE_BOOT_LED_MS)
+	{
+		digitalWrite(boardVerified ? 10 : 11, LOW);
+		bootPending &= ~(1 << CRANE_BOOT_LED);
+		bootTrace[CRANE_BOOT_LED] = now;
+	}
+	
+	//-------------------------------- Everything is done: the green led stays on if the board was verified
+	if(!bootPending)
+	{
+		if(boardVerified) digitalWrite(10,HIGH);
+		if(devMode) printBootTrace();
+	}
+}
+
+/// Prints the time each phase of the boot sequence finished at, in milliseconds since verify()
+/// Phases that have not finished yet are printed as "--"
+///
+void Crane::printBootTrace()
+{
+	const char* names[CRANE_BOOT_PHASES] = { "arduino 2", "arduino 3", "HC-06", "servo", "result", "leds" };
+	Serial.print("Boot:");
+	for(uint8_t p = 0; p < CRANE_BOOT_PHASES; p++)
+	{
+		Serial.print(p ? ", " : " ");
+		Serial.print(names[p]);
+		Serial.print(' ');
+		if(bootPending & (1 << p)) { Serial.print("--"); continue; }
+		Serial.print(bootTrace[p]);
+		Serial.print(" ms");
+	}
+	Serial.println();
+}
+
+/// The update function for arduino 1
+/// gets the gripper height
+///
+void Crane::update1()
+{
+	//-------------------------------- Advance the boot sequence (if running), then handle the messages from the HC-06
+	if(bootPending) updateBoot();
+	pollHC06();
+	
+	//-------------------------------- Time the range sensor (this never waits for it), and record each new (filtered) distance as telemetry
+	if(updateEcho())
+	{
+		int16_t velocity;
+		record(CRANE_TM_DISTANCE, 0, filteredDistance(&velocity));
+		record(CRANE_TM_VELOCITY, 0, velocity);
+	}
+}
+
+/// Runs the range sensor without waiting for it: triggers it once every CRANE_ECHO_CYCLE_MS, and collects the echo timed by echoTick()
+/// Returns true if a new valid distance came in (see latestDistance). A measurement without a valid echo is counted in echoMisses
+///
+bool Crane::updateEcho()
+{
+#if !defined(__AVR__)
+	//-------------------------------- Without Timer2, the echo pin is sampled from here (the resolution is the loop time). There is no tick to come late
+	if(_echoState == 1 || _echoState == 2)
+	{
+		_echoLast = micros();
+		echoTick();
+	}
+#endif
+	bool fresh = false;
+	bool cycled = millis() - _echoTrigger >= CRANE_ECHO_CYCLE_MS;
+	
+	//-------------------------------- Take the state and the width, and stop a measurement that ran past the cycle time, all at once: the echo can finish in between otherwise
+	noInterrupts();
+	uint8_t state = _echoState;
+	uint32_t width = _echoWidth;
+	if(state >= 3) _echoState = 0;
+	else if(state && cycled)
+	{
+#if defined(__AVR__)
+		TIMSK2 &= ~(1 << OCIE2A);
+#endif
+		_echoState = 0;
+	}
+	interrupts();
+	
+	//-------------------------------- The echo is done (the interrupt has stopped): keep the distance if it is in range
+	if(state == 3)
+	{
+		if(width <= CRANE_ECHO_MAX_US)
+		{
+			_distance = (width * 5 + 14) / 29;
+			_distanceTime = _echoTrigger;
+			filterSample(_filter, _distance, _distanceTime);
+			fresh = true;
+		}
+		else echoMisses++;
+	}
+	
+	//-------------------------------- An edge was seen late: the width is not known
+	else if(state == 4) echoLate++;
+	
+	//-------------------------------- A measurement still running after the cycle time of the sensor got no echo
+	else if(state && cycled) echoMisses++;
+	
+	//-------------------------------- Wait for the cycle time of the sensor
+	if(!cycled) return fresh;
+	
+	//-------------------------------- Start sampling the echo pin, then send the pulse to the TRIG pin
+	_echoState = 1;
+	_echoTrigger = millis();
+	_echoLast = micros();
+#if defined(__AVR__)
+	TCNT2 = 0;
+	TIFR2 = 1 << OCF2A;
+	TIMSK2 |= 1 << OCIE2A;
+#endif
+	digitalWrite(A6,HIGH);
+	delayMicroseconds(10);
+	digitalWrite(A6,LOW);
+	return fresh;
+}
+
+/// Samples the echo pin of the range sensor, and times the echo from its rising to its falling edge
+/// Called from the Timer2 interrupt during a measurement. Stops the interrupt once the echo is done
+/// The pin is sampled once per tick: at 20 kHz, the width is known to 50 us (about 8.6 mm of distance)
+/// A tick that comes late (another interrupt kept the interrupts off) cannot tell when the edge it sees came: the measurement is thrown away (state 4)
+void Crane::echoTick()
+{
+#if defined(CRANE_FAST_GPIO)
+	bool high = PIND & (1 << 6);
+#else
+	bool high = digitalRead(6);
+#endif
+	uint32_t now = micros();
+	bool late = (uint16_t)((uint16_t)now - _echoLast) > CRANE_ECHO_LATE_US;
+	_echoLast = now;
+	bool edge = (_echoState == 1 && high) || (_echoState == 2 && !high);
+	if(!edge) return;
+	
+	//-------------------------------- The rising edge starts the echo, the falling edge ends it. A late edge ends the measurement
+	if(late) _echoState = 4;
+	else if(_echoState == 1) { _echoRise = now; _echoState = 2; return; }
+	else
+	{
+		_echoWidth = now - _echoRise;
+		_echoState = 3;
+	}
+#if defined(__AVR__)
+	TIMSK2 &= ~(1 << OCIE2A);
+#endif
+}
+
+/// Runs one distance sample through the filter: a rolling median rejects single bad echoes, then an alpha-beta filter estimates the height and vertical velocity
+/// Fixed point only (Q24.8), so it runs on every sample. Static, so recorded samples can be replayed through it on any host
+///
+void Crane::filterSample(CraneFilter& filter, uint16_t mm, uint32_t ms)
+{
+	//-------------------------------- Add the sample to the window, and take the median of the window (insertion sort, the window is small)
+	filter.window[filter.next] = mm;
+	filter.next = (filter.next + 1) % CRANE_MEDIAN_LEN;
+	if(filter.count < CRANE_MEDIAN_LEN) filter.count++;
+	uint16_t sorted[CRANE_MEDIAN_LEN];
+	for(uint8_t i = 0; i < filter.count; i++)
+	{
+		uint8_t j = i;
+		for(; j > 0 && sorted[j - 1] > filter.window[i]; j--) sorted[j] = sorted[j - 1];
+		sorted[j] = filter.window[i];
+	}
+	int32_t measured = (int32_t)sorted[filter.count / 2] << 8;
+	
+	//-------------------------------- The first sample, or the first after a gap: start from the measurement, standing still
+	uint32_t dt = ms - filter.time;
+	filter.time = ms;
+	if(filter.count == 1 || dt == 0 || dt > CRANE_FILTER_RESET_MS)
+	{
+		filter.height = measured;
+		filter.velocity = 0;
+		return;
+	}
+	
+	//-------------------------------- Predict the height with the velocity, then correct both with the residual
+	int32_t predicted = filter.height + filter.velocity * (int32_t)dt / 1000;
+	int32_t residual = measured - predicted;
+	filter.height = predicted + residual * CRANE_FILTER_ALPHA / 256;
+	filter.velocity += residual * CRANE_FILTER_BETA / 256 * 1000 / (int32_t)dt;
+	
+	//-------------------------------- Keep the velocity in a sane range, so the prediction can not overflow
+	const int32_t maxVelocity = (int32_t)CRANE_FILTER_MAX_V << 8;
+	filter.velocity = filter.velocity > maxVelocity ? maxVelocity : filter.velocity < -maxVelocity ? -maxVelocity : filter.velocity;
+}
+
+/// Returns the filtered distance of the range sensor, in millimetres (0: none yet)
+/// 'velocity' (if given) is set to the vertical velocity, in millimetres per second (positive: moving away from the sensor)
+///
+uint16_t Crane::filteredDistance(int16_t* velocity)
+{
+	if(velocity) *velocity = _filter.velocity / 256;
+	if(!_filter.count || _filter.height < 0) return 0;
+	return (_filter.height + 128) >> 8;
+}
+
+/// Returns the latest valid distance measured by the range sensor, in millimetres (0: none yet)
+/// 'time' (if given) is set to when it was measured (millis). Compare it with millis() to see how old the distance is
+///
+uint16_t Crane::latestDistance(unsigned long* time)
+{
+	if(time) *time = _distanceTime;
+	return _distance;
+}
+
+
+
+
+/* FUNCTIONS ARDUINO 2
+*
+* init2(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+* update2(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead. Hands queued segments to the step engine CRANE_LOOKAHEAD_MS before the running move decelerates
+* verify2(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead. Only starts the self test, which continues in "update()"
+*
+* updateSelfTest(): Advances the stepper self test by one state, and reports the result to arduino 1 ("SELF2:xyz") when done. called from update2()
+* 	The test is a smoke test of the step engine and its timing: the steppers run open loop, so it cannot tell whether a motor turned
+* 
+* setSpeedOf(uint8_t stepper, float rps): Sets the speed of stepper 'stepper' to 'rps' (in rotations per second, rounded to 0.01). Returns the step period in milliseconds
+* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
+*	-> rps: the speed of the stepper motor in rotations per second. Note: the sign of this parameter determines the direction of the movement 
+* 
+* setCentiSpeedOf(uint8_t stepper, int16_t centiRps): Sets the speed of stepper 'stepper' using integer math only
+* 	-> stepper: the ID of the stepper (1 -> stepper 1). 
+*	-> centiRps: the speed of the stepper motor in hundredths of rotations per second. The sign determines the direction, 0 disables the stepper
+* 
+* parseStepCommand(const String& in): Parses a "STEPn:x.xx" speed command without floats, and sets the speed. Returns false if 'in' is not a speed command
+* 	-> in: the received command
+* 
+* LCM(uint32_t a, uint32_t b): Returns the exact LCM of two periods, or 0 if it is longer than CRANE_SYNC_WINDOW
+* 	-> a: a period in microseconds
+* 	-> b: a period in microseconds
+*
+* maX(uint8_t a, uint8_t b): Returns a if a > b. otherwise returns b
+*	-> a: an arbitrary number
+*	-> b: an arbitrary number
+*
+* stepSync(): Steps all motors in a synchronized manner. Queues one chunk of movement on the step engine and returns immediately
+*
+* moveSteps(int32_t steps1, int32_t steps2, int32_t steps3, uint32_t duration): Queues a linear move on the step engine, it starts when the current move is done. Returns false if another move is already waiting
+* 	-> steps1: the amount of steps stepper 1 takes (the sign determines the direction)
+* 	-> steps2: the amount of steps stepper 2 takes (the sign determines the direction)
+*	-> steps3: the amount of steps stepper 3 takes (the sign determines the direction)
+*	-> duration: the duration of the move in microseconds
+*
+* stepTo(uint8_t stepper, double positionFrom, double positionTo): Moves a stepper with a trapezoidal or S-curve velocity profile. Returns false if another move is already waiting
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> positionFrom: the current position of the stepper, in rotations
+*	-> positionTo: the target position of the stepper, in rotations
+*
+* setLimitsOf(uint8_t stepper, float maxRps, float maxAccel, float maxJerk): Sets the motion limits of a stepper, used by stepTo. The first call for a stepper allocates its RAM ramp table (64 bytes, never freed). Returns false if there is no memory for it
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> maxRps: the cruise speed in rotations per second
+*	-> maxAccel: the maximum acceleration in rotations per second^2
+*	-> maxJerk: the maximum jerk in rotations per second^3. 0 gives a trapezoidal profile, anything else an S-curve
+*
+* queueMove(int32_t steps1, int32_t steps2, int32_t steps3, float rps): Queues a move in the look-ahead queue. Consecutive moves blend without stopping. Returns false if the queue is full
+* 	-> steps1: the amount of steps stepper 1 takes (the sign determines the direction)
+* 	-> steps2: the amount of steps stepper 2 takes (the sign determines the direction)
+*	-> steps3: the amount of steps stepper 3 takes (the sign determines the direction)
+*	-> rps: the cruise speed of the stepper with the most steps, in rotations per second (0: its maximum speed)
+*
+* queuedMoves(): Returns the amount of moves in the look-ahead queue
+*
+* moveTo(float x, float z): Queues a move of the trolley (CRANE_AXIS_X) and hoist (CRANE_AXIS_Z) to an absolute position. Returns false if the queue is full
+* 	-> x: the target position of the trolley, in millimetres
+* 	-> z: the target position of the hoist, in millimetres
+*
+* parseMoveCommand(const String& in): Parses a "MOVE:x,z" command (in millimetres) and queues the move. Returns false if 'in' is not a move command
+* 	-> in: the received command
+*
+* positionOf(uint8_t stepper): Returns the position of a stepper in steps, as counted by the step engine
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+*
+* setPositionOf(uint8_t stepper, int32_t steps): Overwrites the position of a stepper, e.g. after homing. Only call this while the stepper is not moving
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> steps: the new position in steps
+*
+* setStepsPerMm(uint8_t stepper, float stepsPerMm): Sets the calibration of a stepper
+* 	-> stepper: the ID of the stepper (1 -> stepper 1)
+* 	-> stepsPerMm: the amount of steps per millimetre of travel
+*
+* isMoving(): Returns true while the step engine is executing (or about to execute) a move
+*
+* stopSteppers(): Stops the step engine immediately, and empties the look-ahead queue
+*
+* startTicker(uint32_t hz): Starts the periodic tick of the step engine (Timer2 on AVR)
+* 	-> hz: the tick frequency (10 kHz - 40 kHz)
+*
+* tick(): Advances the step engine by one tick. Called from the timer interrupt
+*
+* step(uint8_t stepper): Steps the specified stepper once
+* 	-> stepper: the stepper id
+*
+* step(uint8_t stepper, bool direction): Steps the specified stepper once in a specified direction. Ignored while the step engine is moving
+* 	-> stepper: the stepper id
+*	-> direction: the direction the stepper step
+*
+* pulseSteps(uint8_t mask): Steps several steppers once, with a single pulse (grouped port writes on the ATmega328P)
+* 	-> mask: the steppers to step (bit 0: stepper 1, bit 1: stepper 2, bit 2: stepper 3)
+*
+* setDirections(uint8_t mask, uint8_t dir): Sets the direction pins of several steppers at once
+* 	-> mask: the steppers to set (bit 0: stepper 1, bit 1: stepper 2, bit 2: stepper 3)
+*	-> dir: the directions (bit set: forward)
+*
+*
+*/
+
+/// The init function for arduino 2
+/// pinModes, enable stepper motors
+///
+int Crane::init2()
+{
+	//-------------------------------- Begin serial and wire
+	Wire.begin(2);
+	Serial.begin(9600);
+	
+	//-------------------------------- pinModes
+	pinMode(2,OUTPUT); //Step 1
+	pinMode(3,OUTPUT); //Dir 1
+	pinMode(4,OUTPUT); //En 1 [AL]
+	
+	pinMode(5,OUTPUT); //Step 2
+	pinMode(6,OUTPUT); //Dir 2
+	pinMode(7,OUTPUT); //En 2 [AL]
+	
+	pinMode(8,OUTPUT); //Step 3
+	pinMode(9,OUTPUT); //Dir 3
+	pinMode(10,OUTPUT); //En 3 [AL]
+	
+	//-------------------------------- enable stepper drivers
+	digitalWrite(4,LOW);
+	digitalWrite(7,LOW);
+	digitalWrite(10,LOW);
+	
+	//-------------------------------- start the step engine (the ramp tables were generated at compile time)
+	startTicker(CRANE_TICK_HZ);
+}
+
+/// The verify function for arduino 2
+/// Starts the stepper self test, and returns immediately. The test runs from update2(), so received messages keep being handled.
+/// Note: This will move the crane. Be sure to allow for this movement
+int Crane::verify2()
+{
+	//-------------------------------- Test all three steppers, assume they pass until proven otherwise
+	stepperTest = 7;
+	_testLeft = 7;
+	_testState = 1;
+	return 1;
+}
+
+/// The update function for arduino 2
+/// Hands the next queued segment to the step engine shortly before the running move starts to decelerate, and advances the self test or answers pings.
+/// Until then the segment stays in the queue, so the segments queued after it still raise its exit speed (look-ahead)
+void Crane::update2()
+{
+	//-------------------------------- Advance the self test (if running). Otherwise answer the pings that came in (their replies are subscribed, see onFrame)
+	if(_testState) updateSelfTest();
+	else if(subscribed) pushBuffer(1);
+	
+	//-------------------------------- Keep the step engine fed with queued segments, as late as possible. Its exit speed is fixed once it is handed over
+	if(!_nextReady && queuedMoves() && decelIn() <= CRANE_LOOKAHEAD_MS) popSegment();
+}
+
+/// Advances the stepper self test: a smoke test of the step engine and its timing, not of the motors
+/// Each group of steppers moves CRANE_SELFTEST_STEPS forward and back. Steppers in CRANE_SELFTEST_CONCURRENT are tested together, the others one at a time.
+/// The steppers run open loop (nothing measures the motors), so a stepper fails if the engine runs its move too fast or too slow, e.g. a stalled or misconfigured tick. The result is sent to arduino 1 as "SELF2:xyz" (P: pass, F: fail)
+void Crane::updateSelfTest()
+{
+	int32_t steps[3];
+	uint32_t took = millis() - _testTime;
+	bool timeout = took > 2 * CRANE_SELFTEST_TIME + 100;
+	bool early = took < CRANE_SELFTEST_TIME - CRANE_SELFTEST_TIME / 10;
+	
+	switch(_testState)
+	{
+		//-------------------------------- Start the next group: the steppers that can move together, or else the next single stepper
+		case 1:
+		_testGroup = _testLeft & CRANE_SELFTEST_CONCURRENT;
+		if(!_testGroup) _testGroup = _testLeft & -_testLeft;
+		if(!_testGroup) { _testState = 4; break; }
+		_testLeft &= ~_testGroup;
+		
+		//-------------------------------- Move the group forward
+		for(uint8_t a = 0; a < 3; a++)
+			steps[a] = (_testGroup >> a) & 1 ? CRANE_SELFTEST_STEPS : 0;
+		moveSteps(steps[0], steps[1], steps[2], CRANE_SELFTEST_TIME * 1000UL);
+		_testTime = millis();
+		_testState = 2;
+		break;
+		
+		//-------------------------------- Moving forward: once done, check that it took as long as it should, and move back
+		case 2:
+		if(isMoving() && !timeout) break;
+		if(isMoving()) { stopSteppers(); stepperTest &= ~_testGroup; _testState = 1; break; }
+		if(early) stepperTest &= ~_testGroup;
+		for(uint8_t a = 0; a < 3; a++)
+			steps[a] = (_testGroup >> a) & 1 ? -CRANE_SELFTEST_STEPS : 0;
+		moveSteps(steps[0], steps[1], steps[2], CRANE_SELFTEST_TIME * 1000UL);
+		_testTime = millis();
+		_testState = 3;
+		break;
+		
+		//-------------------------------- Moving back: the same check
+		case 3:
+		if(isMoving() && !timeout) break;
+		if(isMoving()) { stopSteppers(); stepperTest &= ~_testGroup; _testState = 1; break; }
+		if(early) stepperTest &= ~_testGroup;
+		_testState = 1;
+		break;
+		
+		//-------------------------------- Report: send the result to arduino 1, and reply to its ping (later pings are answered by update2)
+		case 4:
+		if(devMode) { Serial.print("Step engine smoke test (open loop, the motors are not checked): "); Serial.println(stepperTest, BIN); }
+		sendFrame(1, CRANE_OP_SELF, stepperTest);
+		pushBuffer(1);
+		_testState = 0;
+		break;
+	}
+}
+
+/// Sets the speed of each stepper motor
+/// This allows for synchronous movement of the stepper motors
+/// The speed is rounded to 0.01 rotations per second, and the step period (in milliseconds) is returned
+double Crane::setSpeedOf(uint8_t stepper, float rps)
+{
+	//-------------------------------- Convert to hundredths of rotations per second, and use the integer path
+	int16_t centi = rps < 0 ? (int16_t)(rps * 100 - 0.5) : (int16_t)(rps * 100 + 0.5);
+	setCentiSpeedOf(stepper, centi);
+	
+	//-------------------------------- Return the step period in milliseconds
+	return stepper >= 1 && stepper <= 3 ? _stepPeriod[stepper-1] / 256000.0 : 0;
+}
+
+/// Sets the speed of a stepper motor in hundredths of rotations per second
+/// Integer math only: the step period is CRANE_PERIOD_CENTI (precomputed) divided by the speed, so this is cheap enough to run on every speed command.
+/// The sign of 'centiRps' determines the direction, 0 disables the stepper. The new speed starts with the next chunk of stepSync, which also sets the direction pin
+void Crane::setCentiSpeedOf(uint8_t stepper, int16_t centiRps)
+{
+	if(stepper < 1 || stepper > 3) return;
+	uint8_t s = stepper - 1;
+	
+	//-------------------------------- Calculate the step period (Q24.8 microseconds). 0: disabled
+	uint16_t aCenti = centiRps < 0 ? -centiRps : centiRps;
+	_stepPeriod[s] = aCenti ? CRANE_PERIOD_CENTI / aCenti : 0;
+	
+	//-------------------------------- Remember the direction. The pin is left to the step engine (loadMove), the running move may still be stepping the other way
+	if(centiRps > 0) _speedDir |= 1 << s; else _speedDir &= ~(1 << s);
+}
+
+/// Parses a "STEPn:x.xx" speed command, and sets the speed of stepper n
+/// The speed is read as hundredths of rotations per second, without floats. Digits after the second decimal are ignored.
+/// Returns false if 'in' is not a speed command
+bool Crane::parseStepCommand(const String& in)
+{
+	//-------------------------------- Translate the text in place, and apply it if it is a speed command
+	uint8_t opcode;
+	int32_t stepper, centi;
+	if(!parseCommand((const uint8_t*)in.c_str(), in.length(), opcode, stepper, centi) || opcode != CRANE_OP_STEP) return false;
+	setCentiSpeedOf(stepper, centi);
+	return true;
+}
+
+/// Finds the lowest common multiple of two periods (in Q24.8 microseconds)
+/// Uses the greatest common divisor, so the result is exact.
+/// Returns 0 if the LCM is longer than CRANE_SYNC_WINDOW (or if a period is 0)
+uint32_t Crane::LCM(uint32_t a, uint32_t b)
+{
+	if(a == 0 || b == 0) return 0;
+	
+	//-------------------------------- Find the greatest common divisor (Euclid)
+	uint32_t x = a, y = b;
+	while(y) { uint32_t r = x % y; x = y; y = r; }
+	
+	//-------------------------------- LCM = a / gcd * b, unless that does not fit in the window
+	a /= x;
+	if(a > (CRANE_SYNC_WINDOW << 8) / b) return 0;
+	return a * b;
+}
+
+/// Returns a or b, whichever is highest
+/// 
+/// (For some reason, the standard max() function kept giving me compile errors, so i made this
+uint8_t Crane::maX(uint8_t a, uint8_t b)
+{
+	return a > b ? a : b;
+}
+
+/// Steps the motors synchronously
+/// Queues one chunk of movement at the current speeds on the step engine, and returns immediately.
+/// Call this every loop. The next chunk is queued while the current one runs, so the steppers do not stop in between
+void Crane::stepSync()
+{
+	//-------------------------------- If the next chunk is already waiting, do nothing
+	if(_nextReady) return;
+	
+	//-------------------------------- The step period of each stepper in Q24.8 microseconds (0: disabled)
+	const uint32_t* period = _stepPeriod;
+	
+	//-------------------------------- The chunk lasts the exact LCM of the periods (rounded up to whole microseconds), so every stepper takes a whole amount of steps.
+	//-------------------------------- If the LCM is too long, use a fixed window (at least one period of the slowest stepper)
+	uint32_t window = 0, longest = 0;
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		if(!period[a]) continue;
+		window = longest ? LCM(window, period[a]) : period[a];
+		if(period[a] > longest) longest = period[a];
+		if(!window) break;
+	}
+	if(!longest) return;
+	if(!window || window > (CRANE_SYNC_WINDOW << 8)) window = longest > (CRANE_SYNC_WINDOW << 8) ? longest : (CRANE_SYNC_WINDOW << 8);
+	
+	//-------------------------------- A short chunk is repeated up to CRANE_SYNC_MIN, so the engine does not run dry before loop() queues the next one
+	if(window < (CRANE_SYNC_MIN << 8)) window *= ((CRANE_SYNC_MIN << 8) + window - 1) / window;
+	window = (window + 255) & ~255UL;
+	
+	//-------------------------------- Calculate the steps of each stepper. The time left over is carried into the next chunk, so no steps are lost
+	int32_t steps[3];
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		if(!period[a]) { steps[a] = 0; _syncCarry[a] = 0; continue; }
+		uint32_t t = window + _syncCarry[a];
+		steps[a] = t / period[a];
+		_syncCarry[a] = t % period[a];
+		if(!(_speedDir & (1 << a))) steps[a] = -steps[a];
+	}
+	
+	//-------------------------------- Queue the chunk
+	runTime = window / 256000;
+	moveSteps(steps[0], steps[1], steps[2], window >> 8);
+}
+
+/// Queues a linear move of all three steppers on the step engine
+/// The axis with the most steps (the dominant axis) is stepped at a constant interval, the others follow using Bresenham interpolation.
+/// The move starts as soon as the current move is done. Returns false if another move is already waiting
+bool Crane::moveSteps(int32_t steps1, int32_t steps2, int32_t steps3, uint32_t duration)
+{
+	//-------------------------------- Only one move can wait at a time
+	if(_nextReady) return false;
+	
+	//-------------------------------- Load the move. Nothing to do if no axis moves
+	int32_t steps[3] = {steps1, steps2, steps3};
+	uint32_t events = prepareMove(_next, steps);
+	if(events == 0) return true;
+	
+	//-------------------------------- The interval between two dominant axis steps (Q24.8 microseconds), without a ramp
+	_next.interval = ((uint64_t)duration << 8) / events;
+	_next.ramp = 0;
+	
+	//-------------------------------- Hand the move to the tick interrupt. This must be the last thing done: the slot has to be written before the flag is set
+	CRANE_FENCE();
+	_nextReady = true;
+	return true;
+}
+
+/// Moves stepper 'stepper' from 'positionFrom' to 'positionTo' (in rotations)
+/// The move accelerates and decelerates with the limits set by setLimitsOf, from and to standstill.
+/// Returns false if another move is already waiting
+bool Crane::stepTo(uint8_t stepper, double positionFrom, double positionTo)
+{
+	//-------------------------------- Only existing steppers
+	if(stepper < 1 || stepper > 3) return false;
+	
+	//-------------------------------- Plan the move at the maximum speed of the stepper
+	int32_t steps[3] = {0, 0, 0};
+	steps[stepper-1] = lround((positionTo - positionFrom) * CRANE_STEPS_PER_REV);
+	return planMove(steps, 0, 0, 0);
+}
+
+/// Sets the motion limits of stepper 'stepper'
+/// Speeds are in rotations per second, accelerations in rotations per second^2 and jerks in rotations per second^3.
+/// A jerk of 0 plans trapezoidal profiles, anything else plans jerk limited S-curves. Returns false (and keeps the old limits) if there is no memory for the ramp table
+bool Crane::setLimitsOf(uint8_t stepper, float maxRps, float maxAccel, float maxJerk)
+{
+	if(stepper < 1 || stepper > 3) return false;
+	
+	//-------------------------------- Steppers that keep their compile time limits need no RAM: the table is only allocated for the first custom limits, and then kept (so the heap does not fragment)
+	if((_rampFlash >> (stepper-1)) & 1)
+	{
+		uint16_t* table = (uint16_t*)malloc(CRANE_RAMP_LEN * sizeof(uint16_t));
+		if(!table) return false;
+		_ramp[stepper-1] = table;
+		_rampFlash &= ~(1 << (stepper-1));
+	}
+	
+	_maxVelocity[stepper-1] = maxRps < 0 ? -maxRps : maxRps;
+	_maxAccel[stepper-1] = maxAccel < 0 ? -maxAccel : maxAccel;
+	_maxJerk[stepper-1] = maxJerk < 0 ? -maxJerk : maxJerk;
+	
+	//-------------------------------- Build the ramp table in RAM to replace the compile time one. Do not change the limits of a stepper while it moves
+	buildRamp(stepper);
+	return true;
+}
+
+/// Queues a move in the look-ahead queue
+/// 'rps' is the cruise speed of the axis with the most steps, in rotations per second (0: the maximum speed of that axis).
+/// Consecutive moves blend at the highest junction speed the axes allow. Returns false if the queue is full
+bool Crane::queueMove(int32_t steps1, int32_t steps2, int32_t steps3, float rps)
+{
+	//-------------------------------- Check if there is room in the queue
+	if(queuedMoves() == CRANE_SEGMENT_COUNT) return false;
+	
+	//-------------------------------- Fill in the new segment, and find its dominant axis
+	CraneSegment& seg = _segments[_segTail & (CRANE_SEGMENT_COUNT - 1)];
+	seg.steps[0] = steps1; seg.steps[1] = steps2; seg.steps[2] = steps3;
+	seg.events = 0;
+	seg.axis = 0;
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		uint32_t n = seg.steps[a] < 0 ? -seg.steps[a] : seg.steps[a];
+		if(n > seg.events) { seg.events = n; seg.axis = a; }
+	}
+	if(seg.events == 0) return true;
+	
+	//-------------------------------- Limit the cruise speed to the maximum speed of the dominant axis
+	float vMax = _maxVelocity[seg.axis] * CRANE_STEPS_PER_REV;
+	seg.nominal = rps < 0 ? -rps * CRANE_STEPS_PER_REV : rps * CRANE_STEPS_PER_REV;
+	if(seg.nominal <= 0 || seg.nominal > vMax) seg.nominal = vMax;
+	
+	//-------------------------------- The junction with the previous queued segment. The first segment starts at the speed the engine leaves it
+	seg.maxEntry = queuedMoves() ? junctionSpeed(_segments[(_segTail - 1) & (CRANE_SEGMENT_COUNT - 1)], seg) : _headEntry;
+	seg.entry = 0;
+	_segTail++;
+	for(uint8_t a = 0; a < 3; a++) _target[a] += seg.steps[a];
+	
+	//-------------------------------- Replan the queue with the new segment at the end
+	planSegments();
+	return true;
+}
+
+/// Returns the amount of moves waiting in the look-ahead queue
+/// 
+///
+uint8_t Crane::queuedMoves()
+{
+	return (uint8_t)(_segTail - _segHead);
+}
+
+/// Queues a move of the trolley and hoist to an absolute position (in millimetres)
+/// The move starts from where the previously queued moves end, so consecutive targets blend like queueMove.
+/// Returns false if the queue is full
+bool Crane::moveTo(float x, float z)
+{
+	//-------------------------------- If nothing is planned, start from the current position
+	if(!isMoving() && !queuedMoves())
+		for(uint8_t a = 0; a < 3; a++) _target[a] = positionOf(a+1);
+	
+	//-------------------------------- Convert the target to steps, and queue the difference
+	int32_t steps[3] = {0, 0, 0};
+	steps[CRANE_AXIS_X-1] = lround(x * _stepsPerMm[CRANE_AXIS_X-1]) - _target[CRANE_AXIS_X-1];
+	steps[CRANE_AXIS_Z-1] = lround(z * _stepsPerMm[CRANE_AXIS_Z-1]) - _target[CRANE_AXIS_Z-1];
+	return queueMove(steps[0], steps[1], steps[2], 0);
+}
+
+/// Parses a "MOVE:x,z" command, and queues a move to that position (in millimetres)
+/// This lets arduino 1 send one absolute target instead of streaming speed commands.
+/// Returns false if 'in' is not a move command
+bool Crane::parseMoveCommand(const String& in)
+{
+	//-------------------------------- Translate the text in place (to 0.01 mm), and queue the move if it is a move command
+	uint8_t opcode;
+	int32_t x, z;
+	if(!parseCommand((const uint8_t*)in.c_str(), in.length(), opcode, x, z) || opcode != CRANE_OP_MOVE) return false;
+	moveTo(x / 100.0, z / 100.0);
+	return true;
+}
+
+/// Returns the position of stepper 'stepper' in steps
+/// The step engine counts every step in the interrupt, so the value is read with interrupts blocked.
+/// 
+int32_t Crane::positionOf(uint8_t stepper)
+{
+	if(stepper < 1 || stepper > 3) return 0;
+	noInterrupts();
+	int32_t position = _position[stepper-1];
+	interrupts();
+	return position;
+}
+
+/// Overwrites the position of stepper 'stepper' (in steps)
+/// Use this to set the origin, e.g. after homing. Only call this while the stepper is not moving
+/// 
+void Crane::setPositionOf(uint8_t stepper, int32_t steps)
+{
+	if(stepper < 1 || stepper > 3) return;
+	noInterrupts();
+	_position[stepper-1] = steps;
+	interrupts();
+	_target[stepper-1] = steps;
+}
+
+/// Sets the calibration of stepper 'stepper', in steps per millimetre
+/// 
+/// 
+void Crane::setStepsPerMm(uint8_t stepper, float stepsPerMm)
+{
+	if(stepper < 1 || stepper > 3 || stepsPerMm == 0) return;
+	_stepsPerMm[stepper-1] = stepsPerMm;
+}
+
+/// Returns the highest speed at which segment 'from' can blend into segment 'to'
+/// The speed change of every axis at the junction has to stay below CRANE_JUNCTION_JUMP steps per second.
+/// Moves in the same direction blend at full speed, reversing axes nearly stop
+float Crane::junctionSpeed(const CraneSegment& from, const CraneSegment& to)
+{
+	float v = from.nominal < to.nominal ? from.nominal : to.nominal;
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		//-------------------------------- The speed change of this axis, per unit of dominant axis speed
+		float d = (float)from.steps[a] / from.events - (float)to.steps[a] / to.events;
+		if(d < 0) d = -d;
+		if(d * v > CRANE_JUNCTION_JUMP) v = CRANE_JUNCTION_JUMP / d;
+	}
+	return v;
+}
+
+/// Recalculates the entry speeds of all queued segments
+/// Backwards from the last segment (which has to end at standstill), each segment enters no faster than it can still brake.
+/// Then forwards from the first segment (whose entry speed is fixed), each segment enters no faster than the previous one can accelerate to
+void Crane::planSegments()
+{
+	uint8_t count = queuedMoves();
+	if(count == 0) return;
+	
+	//-------------------------------- Backward pass: the last segment ends at standstill
+	float exit = 0;
+	for(uint8_t n = count; n > 1; n--)
+	{
+		CraneSegment& seg = _segments[(_segHead + n - 1) & (CRANE_SEGMENT_COUNT - 1)];
+		float a = _maxAccel[seg.axis] * CRANE_STEPS_PER_REV;
+		float v = sqrt(exit*exit + 2*a*seg.events);
+		seg.entry = v < seg.maxEntry ? v : seg.maxEntry;
+		exit = seg.entry;
+	}
+	
+	//-------------------------------- Forward pass: the first segment enters at the speed the engine leaves it
+	float entry = _headEntry;
+	for(uint8_t n = 0; n < count; n++)
+	{
+		CraneSegment& seg = _segments[(_segHead + n) & (CRANE_SEGMENT_COUNT - 1)];
+		if(n == 0 || seg.entry > entry) seg.entry = entry;
+		float a = _maxAccel[seg.axis] * CRANE_STEPS_PER_REV;
+		entry = sqrt(seg.entry*seg.entry + 2*a*seg.events);
+	}
+}
+
+/// Hands the first queued segment to the step engine
+/// Its exit speed is the entry speed of the segment after it, which is fixed from now on.
+/// Only call this if the next slot of the engine is free
+void Crane::popSegment()
+{
+	//-------------------------------- The segment ends at the entry speed of the next segment, or at standstill if it is the last
+	CraneSegment& seg = _segments[_segHead & (CRANE_SEGMENT_COUNT - 1)];
+	float exit = queuedMoves() > 1 ? _segments[(_segHead + 1) & (CRANE_SEGMENT_COUNT - 1)].entry : 0;
+	
+	//-------------------------------- Plan the move, and fix the entry speed of the next segment
+	planMove(seg.steps, seg.entry, seg.nominal, exit);
+	_headEntry = exit;
+	_segHead++;
+}
+
+/// Returns the time until the running move starts to decelerate, in milliseconds
+/// Estimated from the current interval, so it is never too short while the move accelerates. 0 if the engine is idle or already decelerating
+///
+uint32_t Crane::decelIn()
+{
+	//-------------------------------- Read the progress of the move (the tick interrupt writes it)
+	noInterrupts();
+	bool moving = _moving;
+	uint32_t event = _moveEvent;
+	uint32_t interval = _moveInterval;
+	interrupts();
+	
+	//-------------------------------- The steps left until the decelerating steps, at the current interval. _move only changes in loadMove, and the next slot is empty here
+	uint32_t cruise = _move.events - (_move.ramp ? _move.decelSteps : 0);
+	if(!moving || event >= cruise) return 0;
+	return (uint64_t)(cruise - event) * interval / 256000;
+}
+
+/// Fills in the steps and directions of a move
+/// Returns the amount of steps of the dominant axis
+/// 
+uint32_t Crane::prepareMove(CraneMove& move, const int32_t* steps)
+{
+	//-------------------------------- Store the absolute amount of steps and the directions
+	move.events = 0;
+	move.dir = 0;
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		if(steps[a] > 0) move.dir |= 1 << a;
+		move.steps[a] = steps[a] < 0 ? -steps[a] : steps[a];
+		if(move.steps[a] > move.events) move.events = move.steps[a];
+	}
+	return move.events;
+}
+
+/// Plans a ramped move into the next slot of the step engine
+/// 'entry', 'nominal' and 'exit' are speeds of the dominant axis in steps per second (nominal 0: its maximum speed).
+/// The ramps are positions in the ramp table of the dominant axis, so the tick interrupt only looks up intervals. Returns false if the slot is taken
+bool Crane::planMove(const int32_t* steps, float entry, float nominal, float exit)
+{
+	//-------------------------------- Only one move can wait at a time
+	if(_nextReady) return false;
+	
+	//-------------------------------- Load the move. Nothing to do if no axis moves
+	uint32_t events = prepareMove(_next, steps);
+	if(events == 0) return true;
+	
+	//-------------------------------- Find the dominant axis, and limit the cruise speed to its maximum
+	uint8_t d = 0;
+	while(_next.steps[d] != events) d++;
+	float vMax = _maxVelocity[d] * CRANE_STEPS_PER_REV;
+	if(nominal <= 0 || nominal > vMax) nominal = vMax;
+	
+	//-------------------------------- Find the ramp positions of the entry, cruise and exit speeds
+	uint32_t from = rampIndexOf(d, entry);
+	uint32_t top = rampIndexOf(d, nominal);
+	uint32_t to = rampIndexOf(d, exit);
+	if(from > top) from = top;
+	if(to > top) to = top;
+	
+	//-------------------------------- If the move is too short to reach the cruise speed, accelerate until the ramps meet (triangular profile)
+	_next.interval = 256000000.0 / nominal;
+	if((top - from) + (top - to) > events)
+	{
+		top = (events + from + to) / 2;
+		if(top < from) top = from;
+		if(top < to) top = to;
+		_next.interval = (uint32_t)rampAt(d, (top ? top - 1 : 0) >> _rampShift[d]) << 8;
+	}
+	
+	//-------------------------------- Store the ramps
+	_next.ramp = _ramp[d];
+	_next.flash = (_rampFlash >> d) & 1;
+	_next.shift = _rampShift[d];
+	_next.accelFrom = from;
+	_next.accelSteps = top - from > events ? events : top - from;
+	_next.decelTo = to;
+	_next.decelSteps = top - to > events - _next.accelSteps ? events - _next.accelSteps : top - to;
+	
+	//-------------------------------- Hand the move to the tick interrupt. This must be the last thing done: the slot has to be written before the flag is set
+	CRANE_FENCE();
+	_nextReady = true;
+	return true;
+}
+
+/// Fills the RAM ramp table of stepper 'stepper' (allocated by setLimitsOf) with its acceleration from standstill up to its maximum speed
+/// Entry n holds the interval of ramp step n (in microseconds). If the ramp is longer than the table, each entry holds the average of a power-of-two group of steps.
+/// Moves use part of the table: a move entering at a certain speed starts at the ramp position of that speed
+void Crane::buildRamp(uint8_t stepper)
+{
+	//-------------------------------- Convert the limits to steps
+	uint8_t s = stepper - 1;
+	uint16_t* table = (uint16_t*)_ramp[s];
+	float vMax = _maxVelocity[s] * CRANE_STEPS_PER_REV;
+	float aMax = _maxAccel[s] * CRANE_STEPS_PER_REV;
+	float jMax = _maxJerk[s] * CRANE_STEPS_PER_REV;
+	if(vMax <= 0 || aMax <= 0) { vMax = 1000; aMax = 2000; }
+	
+	//-------------------------------- Count the steps it takes to reach the maximum speed
+	float v = 0, a = 0;
+	uint32_t ramp = 0;
+	while(v < vMax)
+	{
+		rampStep(v, a, vMax, aMax, jMax);
+		ramp++;
+	}
+	
+	//-------------------------------- Find the amount of steps each table entry has to cover
+	_rampShift[s] = 0;
+	while(((ramp - 1) >> _rampShift[s]) >= CRANE_RAMP_LEN) _rampShift[s]++;
+	
+	//-------------------------------- Fill the table with the average interval of the steps each entry covers
+	v = 0; a = 0;
+	float sum = 0;
+	for(uint32_t i = 0; i < ramp; i++)
+	{
+		sum += rampStep(v, a, vMax, aMax, jMax) * 1000000;
+		if(((i + 1) & ((1UL << _rampShift[s]) - 1)) == 0 || i + 1 == ramp)
+		{
+			float dt = sum / ((i & ((1UL << _rampShift[s]) - 1)) + 1);
+			table[i >> _rampShift[s]] = dt > 65535 ? 65535 : (uint16_t)dt;
+			sum = 0;
+		}
+	}
+	_rampSteps[s] = ramp;
+}
+
+/// Returns the ramp position of stepper 'stepper' at which 'speed' (steps/s) is reached
+/// Binary searches the ramp table for the first entry that is at least as fast.
+/// 
+uint32_t Crane::rampIndexOf(uint8_t stepper, float speed)
+{
+	if(speed <= 0) return 0;
+	if(speed >= _maxVelocity[stepper] * CRANE_STEPS_PER_REV) return _rampSteps[stepper];
+	
+	//-------------------------------- Search the table (the intervals get shorter along the ramp). Below about 15.3 steps/s the interval does not fit 16 bits:
+	//-------------------------------- that is slower than any entry, so it is clamped (converting it as it is would be undefined, and wraps on AVR and x86)
+	uint16_t interval = speed < 1000000.0 / 65535 ? 65535 : 1000000.0 / speed;
+	uint8_t low = 0, high = ((_rampSteps[stepper] - 1) >> _rampShift[stepper]) + 1;
+	while(low < high)
+	{
+		uint8_t mid = (low + high) / 2;
+		if(rampAt(stepper, mid) > interval) low = mid + 1; else high = mid;
+	}
+	
+	//-------------------------------- Convert the entry to a ramp position
+	uint32_t index = (uint32_t)low << _rampShift[stepper];
+	return index < _rampSteps[stepper] ? index : _rampSteps[stepper];
+}
+
+/// Returns entry 'entry' of the ramp table of stepper 'stepper' (0, 1, 2)
+/// The table is either the compile time one in flash, or the one built by setLimitsOf in RAM
+/// 
+uint16_t Crane::rampAt(uint8_t stepper, uint8_t entry)
+{
+	return (_rampFlash >> stepper) & 1 ? pgm_read_word(_ramp[stepper] + entry) : _ramp[stepper][entry];
+}
+
+/// Advances a velocity profile by one step
+/// 'v' (steps/s) and 'a' (steps/s^2) are updated, and the duration of the step (s) is returned.
+/// Without jerk (jMax = 0) the step is solved exactly for constant acceleration, otherwise the acceleration ramps up and down with the jerk
+float Crane::rampStep(float& v, float& a, float vMax, float aMax, float jMax)
+{
+	float dt;
+	
+	//-------------------------------- Trapezoidal: constant acceleration
+	if(jMax <= 0)
+	{
+		float vNext = sqrt(v*v + 2*aMax);
+		dt = 2 / (v + vNext);
+		v = vNext;
+		return dt;
+	}
+	
+	//-------------------------------- S-curve, first step: from standstill only the jerk moves the stepper
+	if(v <= 0)
+	{
+		dt = cbrt(6 / jMax);
+		a = jMax * dt;
+		if(a > aMax) a = aMax;
+		v = jMax * dt * dt / 2;
+		return dt;
+	}
+	
+	//-------------------------------- S-curve: ramp the acceleration down when nearing the cruise speed, hold it at the maximum, or ramp it up
+	float j = (vMax - v <= a*a / (2*jMax)) ? -jMax : (a < aMax ? jMax : 0);
+	dt = 2 / (v + sqrt(v*v + 2*a));
+	v += a*dt + j*dt*dt/2;
+	a += j*dt;
+	if(a > aMax) a = aMax;
+	
+	//-------------------------------- Once the acceleration is gone, the cruise speed has been reached
+	if(a <= 0) { a = 0; v = vMax; }
+	return dt;
+}
+
+/// Stops the step engine immediately, and empties the look-ahead queue
+/// The positions keep the steps that were taken. Stopping at speed can make the steppers skip steps
+/// 
+void Crane::stopSteppers()
+{
+	noInterrupts();
+	_nextReady = false;
+	_moving = false;
+	interrupts();
+	_segHead = _segTail;
+	_headEntry = 0;
+}
+
+/// Returns true while the step engine is executing a move, or has one waiting
+/// 
+///
+bool Crane::isMoving()
+{
+	return _moving || _nextReady;
+}
+
+/// Starts the periodic tick of the step engine
+/// On AVR, Timer2 is used in CTC mode with a prescaler of 8 (Timer1 is used by the Servo library)
+/// On other architectures, tick() must be called externally 'hz' times per second
+void Crane::startTicker(uint32_t hz)
+{
+	//-------------------------------- The time between two ticks (Q24.8 microseconds)
+	_tickPeriod = (1000000UL << 8) / hz;
+	_tickCrane = this;
+	
+#if defined(__AVR__)
+	//-------------------------------- Timer2: CTC mode, prescaler 8, compare interrupt
+	noInterrupts();
+	TCCR2A = 1 << WGM21;
+	TCCR2B = 1 << CS21;
+	TCNT2 = 0;
+	OCR2A = (F_CPU / 8) / hz - 1;
+	TIMSK2 |= 1 << OCIE2A;
+	interrupts();
+#endif
+}
+
+/// Advances the step engine by one tick
+/// Every time the interval of the dominant axis has passed, each axis steps if its Bresenham error term overflows. The dominant axis steps once per tick at most.
+/// Keep this function short: it runs in the timer interrupt
+void Crane::tick()
+{
+	//-------------------------------- If idle, start the waiting move (if any)
+	if(!_moving)
+	{
+		if(!_nextReady) return;
+		_movePhase = 0;
+		loadMove();
+	}
+	
+	//-------------------------------- Wait until the interval of the dominant axis has passed
+	_movePhase += _tickPeriod;
+	if(_movePhase < _moveInterval) return;
+	_movePhase -= _moveInterval;
+	
+	//-------------------------------- At most one step per tick: an interval shorter than the tick runs at the tick rate, without building up a debt of steps
+	if(_movePhase >= _tickPeriod) _movePhase = 0;
+	
+	//-------------------------------- Step each axis whose error term overflows, all with the same pulse
+	uint8_t mask = 0;
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		_bresErr[a] += _move.steps[a];
+		if(_bresErr[a] >= (int32_t)_move.events)
+		{
+			_bresErr[a] -= _move.events;
+			mask |= 1 << a;
+			_position[a] += (_move.dir >> a) & 1 ? 1 : -1;
+		}
+	}
+	pulseSteps(mask);
+	
+	//-------------------------------- Once the dominant axis has taken all its steps, continue with the waiting move straight away (no stop in between)
+	if(++_moveEvent >= _move.events)
+	{
+		if(_nextReady) loadMove(); else _moving = false;
+		return;
+	}
+	
+	//-------------------------------- Look up the interval before the next step
+	_moveInterval = intervalOf(_moveEvent);
+}
+
+/// Starts the move in the next slot
+/// Sets the direction pins and resets the Bresenham error terms. The phase carries over, so back to back moves keep their timing.
+/// Called from tick(), right after it saw _nextReady set
+void Crane::loadMove()
+{
+	//-------------------------------- The slot is complete once the flag is seen set (tick checked it): read it only after that, and hand it back once it is read
+	CRANE_FENCE();
+	_move = _next;
+	CRANE_FENCE();
+	_nextReady = false;
+	
+	//-------------------------------- Set the direction pins, and start the error terms halfway so the following axes step in the middle of their interval
+	setDirections(7, _move.dir);
+	for(uint8_t a = 0; a < 3; a++)
+		_bresErr[a] = _move.events / 2;
+	
+	_moveEvent = 0;
+	_moveInterval = intervalOf(0);
+	_moving = true;
+}
+
+/// Returns the interval before step 'event' of the current move (Q24.8 microseconds)
+/// Accelerating steps read the ramp table forwards from the entry speed, decelerating steps read it backwards down to the exit speed.
+/// This is a table lookup only: it runs in the tick interrupt
+uint32_t Crane::intervalOf(uint32_t event)
+{
+	//-------------------------------- Find the ramp position of this step (cruising steps have none)
+	if(!_move.ramp) return _move.interval;
+	uint32_t left = _move.events - event, index;
+	if(event < _move.accelSteps) index = _move.accelFrom + event;
+	else if(left <= _move.decelSteps) index = _move.decelTo + left - 1;
+	else return _move.interval;
+	
+	//-------------------------------- Look up the interval, from flash or from RAM
+	const uint16_t* entry = _move.ramp + (index >> _move.shift);
+	return (uint32_t)(_move.flash ? pgm_read_word(entry) : *entry) << 8;
+}
+
+/// Step stepper 'stepper' once
+/// The 'stepper' parameter specifies which stepper to drive (1,2,3)
+/// 
+void Crane::step(uint8_t stepper)
+{
+	//-------------------------------- Pulse the respective stepper step pin
+	pulseSteps(1 << (stepper-1));
+}
+
+/// Step stepper 'stepper' once, with direction 'direction'
+/// Does nothing while the step engine is moving: it owns the direction pins until the move is done
+/// 
+void Crane::step(uint8_t stepper, bool direction)
+{
+	if(isMoving()) return;
+	
+	//-------------------------------- set the respective stepper dir pin
+	setDirections(1 << (stepper-1), direction ? 0xFF : 0);
+	
+	//-------------------------------- Pulse the respective stepper step pin
+	pulseSteps(1 << (stepper-1));
+}
+
+/// Steps every stepper in 'mask' once, with one shared pulse
+/// On the ATmega328P this is one write per port to raise and one to lower all STEP pins, so a tick costs the same for one or three steppers.
+/// Other boards fall back to digitalWrite
+void Crane::pulseSteps(uint8_t mask)
+{
+#if defined(CRANE_FAST_GPIO)
+	//-------------------------------- Raise and lower the STEP pins. Interrupts are blocked, so the read-modify-writes do not race the tick interrupt
+	uint8_t d = CRANE_STEP_PORTD(mask), b = CRANE_STEP_PORTB(mask);
+	uint8_t sreg = SREG;
+	cli();
+	PORTD |= d;
+	PORTB |= b;
+	_delay_us(CRANE_PULSE_US);
+	PORTD &= ~d;
+	PORTB &= ~b;
+	SREG = sreg;
+#else
+	//-------------------------------- Raise all STEP pins, wait, and lower them
+	for(uint8_t a = 0; a < 3; a++) if(mask & (1 << a)) digitalWrite(2+a*3,HIGH);
+	delayMicroseconds(CRANE_PULSE_US);
+	for(uint8_t a = 0; a < 3; a++) if(mask & (1 << a)) digitalWrite(2+a*3,LOW);
+#endif
+}
+
+/// Sets the DIR pins of the steppers in 'mask' to the matching bits of 'dir'
+/// 
+/// 
+void Crane::setDirections(uint8_t mask, uint8_t dir)
+{
+#if defined(CRANE_FAST_GPIO)
+	//-------------------------------- Write the DIR pins of both ports at once
+	uint8_t sreg = SREG;
+	cli();
+	PORTD = (PORTD & ~CRANE_DIR_PORTD(mask)) | CRANE_DIR_PORTD(mask & dir);
+	PORTB = (PORTB & ~CRANE_DIR_PORTB(mask)) | CRANE_DIR_PORTB(mask & dir);
+	SREG = sreg;
+#else
+	for(uint8_t a = 0; a < 3; a++) if(mask & (1 << a)) digitalWrite(3+a*3, (dir >> a) & 1);
+#endif
+}
+
+
+
+
+
+
+/* FUNCTIONS ARDUINO 3
+*
+* init3(): initializes the arduino. called externally. Dont call directly, call "verify()" instead
+* update3(): Excecutes repetitive tasks. called externally. Dont call directly, call "update()" instead
+* verify3(): checks the integrity of the construction. called externally. Dont call directly, call "verify()" instead
+*
+* createCustomChars(): Creates the custom characters for the LCD screen
+*
+*/
+
+
+
+/// The init function for arduino 3
+/// pinModes, Display splash screen
+///
+int Crane::init3()
+{
+	//-------------------------------- pinModes
+	pinMode(9,OUTPUT);
+	pinMode(10,OUTPUT);
+	pinMode(11,OUTPUT);
+	
+	//-------------------------------- initialize display
+	_lcd.begin(16,2);
+	_lcd.setCursor(0,0);
+	
+	//-------------------------------- verify the board
+	verify();
+	delay(2500);
+	
+	//-------------------------------- if not in dev mode, display company splash screen and death toll
+	if(!devMode)
+	{
+		String name = "CDGMD I1             ";
+		String comp = "CDGMD";
+		
+		//-------------------------------- Display company name
+		_lcd.clear();
+		_lcd.home();
+		_lcd.print(comp);
+		
+		//-------------------------------- Scroll construction name to the left
+		for(int x = 15; x != -1; x--)
+		{
+			_lcd.setCursor(0,1);
+			_lcd.print("                ");
+			_lcd.setCursor(x,1);
+			_lcd.print(name);
+			delay(250);
+		}
+		
+		//-------------------------------- Scroll construction name to the left
+		delay(2500);
+		for(int x = 0; x < name.length(); x++)
+		{
+			
+			_lcd.scrollDisplayLeft();
+			delay(250);
+		}
+		delay(1000);
+		
+		//-------------------------------- display death toll
+		_lcd.clear();
+		_lcd.home();
+		_lcd.write("In loving memory");
+		_lcd.setCursor(0,1);
+		_lcd.write("7 Arduinos");
+		delay(1500);
+		_lcd.setCursor(0,1);
+		_lcd.write("5 Drivers       ");
+		delay(1500);
+		_lcd.setCursor(0,1);
+		_lcd.write("Countless HC-06 ");
+		delay(1500);
+		
+	}else
+	{ _lcd.print("dev Mode"); delay(1500); }
+
+	//-------------------------------- Clear everything. This is to reset everything with the scrolling.
+	_lcd.begin(16,2);
+	_lcd.setCursor(0,0);
+	createCustomChars();
+	
+	
+}
+
+/// The update function for arduino 3
+/// Display the UI of the crane.
+/// Note: because the UI is on arduino 3, and the step functions are on arduino 2 and arduino 1 controls the step functions, ensure coordination of the UI elements between the arduinos
+void Crane::update3()
+{
+	//-------------------------------- Clear the display
+	_lcd.clear();
+	_lcd.setCursor(14,0);
+	
+	//-------------------------------- If bluetooth connected, just display the connected graphic
+	if(blueConnected)
+	{
+		_lcd.write(char(5));
+		_lcd.write(char(7));
+	}else
+	{
+	//-------------------------------- Just loop over the connection frames if bluetooth not connected
+		frameConnect++;
+		if(frameConnect == 4) frameConnect = 0;
+		switch(frameConnect)
+		{
+			case 0: _lcd.write(char(4)); break;
+			case 1: _lcd.write(char(5)); break;
+			case 2: _lcd.write(char(5)); _lcd.write(char(6)); break;
+			case 3: _lcd.write(char(5)); _lcd.write(char(7)); break;
+		}
+		digitalWrite(10,frameConnect == 0 || frameConnect == 2);
+	}
+	
+	//-------------------------------- Set the status LED (the higher the condition, the higher priority it has
+	
+	//-------------------------------- Set led to yellow if the voltage is lower than 10.75 volts
+	if(voltage < 10.75)
+	{
+		analogWrite(9,255);
+		analogWrite(11,84);
+		analogWrite(10,0);
+	}
+	
+	//-------------------------------- If bluetooth was not connected, halt the if-else braiding. The status LED was set earlier
+	else if(!blueConnected) {}
+	
+	//-------------------------------- If the crane is in standby, set LED to white
+	else if(statusString == "Standby" || statusString == "Cooling")
+	{
+		digitalWrite(9,HIGH);
+		digitalWrite(11,HIGH);
+		digitalWrite(10,HIGH);
+	}
+	
+	//-------------------------------- If the board was not verified, set LED to green
+	else if(!boardVerified)
+	{
+		digitalWrite(9,LOW);
+		digitalWrite(11,HIGH);
+		digitalWrite(10,LOW);
+	}
+
+	//-------------------------------- There is nothing to display, turn of status LED.
+	else 
+	{
+		digitalWrite(9,LOW);
+		digitalWrite(11,LOW);
+		digitalWrite(10,LOW);
+	}
+	
+	//-------------------------------- print battery graphic based on voltage level
+	_lcd.setCursor(0,0);
+	_lcd.write(char(floor(voltage*2)-20));
+	
+	//-------------------------------- print current law of operation
+	_lcd.setCursor(3,0);
+	if(law == 0x00)
+	{
+		_lcd.print("Direct");
+	} else if(law == 0x02)
+	{
+		_lcd.print("Prec.");
+	}
+	
+	//-------------------------------- print horizontal movement of crane
+	_lcd.setCursor(13,1);
+	if(stateX < -1) _lcd.print("<"); else if(stateX == -1) _lcd.print("("); else if(stateX == 0) _lcd.print("|"); else if(stateX == 1) _lcd.print(")"); else _lcd.print(">");
+	
+	//-------------------------------- print vertical movement of crane
+	_lcd.setCursor(15,1);
+	if(stateY < -1) _lcd.print("_"); else if(stateY == -1) _lcd.print(","); else if(stateY == 0) _lcd.print("-"); else if(stateY == 1) _lcd.print("'"); else _lcd.print("^");
+	
+	//-------------------------------- print the status string
+	_lcd.setCursor(0,1);
+	_lcd.print(statusString);
+	
+	
+	
+}
+
+/// The verify function for arduino 3
+/// Displays verification outcome, and test the LEDs
+/// 
+int Crane::verify3()
+{
+	
+	//-------------------------------- Display "Starting..."
+	_lcd.clear();
+	_lcd.home();
+	_lcd.write("Starting...");
+	digitalWrite(9,HIGH);
+	digitalWrite(10,HIGH);
+	digitalWrite(11,HIGH);
+	delay(400);
+	digitalWrite(9,LOW);
+	digitalWrite(10,LOW);
+	digitalWrite(11,LOW);
+	
+	//-------------------------------- While Arduinos 1 and 2 verify, display a line graphic. The ping reply is pushed as soon as the ping is in, and the graphic stops once the board is verified
+	for(int x = 0; x < 16 && !boardVerified; x++)
+	{ _lcd.setCursor(x,1); _lcd.write("-"); waitBus(600); pushBuffer(1); }
+
+	//-------------------------------- Wait a bit more, unless the board has been verified
+	for(unsigned long start = millis(); !boardVerified && millis() - start < 4500; ) waitBus(10);
+	_lcd.clear();
+	_lcd.home();
+	
+	//-------------------------------- If the board has verified, show "I2C: PASS"
+	if(boardVerified) 
+	_lcd.write("I2C: PASS");
+	
+	//-------------------------------- if the board has not been verified, show "I2C: FAIL"
+	else
+	{ _lcd.write("I2C: FAIL"); statusString = "I2C Fail"; }
+
+	//-------------------------------- display HC06 Status
+	_lcd.setCursor(0,1);
+	if(blueState == 0)
+		_lcd.print("HC-06: --"); //Bluetooth neither confirmed working or fail
+	if(blueState == 1)
+		_lcd.print("HC-06: OK"); //Bluetooth confirmed working
+	if(blueState == 2)
+		_lcd.print("HC-06: ERR"); //Bluetooth legible, but not working properly
+	if(blueState == 3)
+		_lcd.print("HC-06: INOP"); //Bluetooth confirmed fail
+	
+	//-------------------------------- Cycle the RGB LED
+	delay(2000);
+	digitalWrite(9,HIGH);
+	digitalWrite(10,LOW);
+	digitalWrite(11,LOW);
+	delay(1000);
+	digitalWrite(9,LOW);
+	digitalWrite(10,HIGH);
+	digitalWrite(11,LOW);
+	delay(1000);
+	digitalWrite(9,LOW);
+	digitalWrite(10,LOW);
+	digitalWrite(11,HIGH);
+	delay(1000);
+	digitalWrite(9,LOW);
+	digitalWrite(10,LOW);
+	digitalWrite(11,LOW);
+	
+	
+	
+}
+
+/// Creates the custom characters for the LCD screen
+/// 
+/// Note: call this function only once!!
+void Crane::createCustomChars()
+{
+	//-------------------------------- declares the temporary variable
+	byte customChar[] = {0, 0, 0, 0, 0, 0, 0, 0};
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B01110;
+	customChar[1] = B10001;
+	customChar[2] = B10001;
+	customChar[3] = B10001;
+	customChar[4] = B10001;
+	customChar[5] = B10001;
+	customChar[6] = B10001;
+	customChar[7] = B11111;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(0,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B01110;
+	customChar[1] = B10001;
+	customChar[2] = B10001;
+	customChar[3] = B10001;
+	customChar[4] = B10001;
+	customChar[5] = B11111;
+	customChar[6] = B11111;
+	customChar[7] = B11111;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(1,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B01110;
+	customChar[1] = B10001;
+	customChar[2] = B10001;
+	customChar[3] = B11111;
+	customChar[4] = B11111;
+	customChar[5] = B11111;
+	customChar[6] = B11111;
+	customChar[7] = B11111;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(2,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B01110;
+	customChar[1] = B11111;
+	customChar[2] = B11111;
+	customChar[3] = B11111;
+	customChar[4] = B11111;
+	customChar[5] = B11111;
+	customChar[6] = B11111;
+	customChar[7] = B11111;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(3,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B00000;
+	customChar[1] = B00000;
+	customChar[2] = B00000;
+	customChar[3] = B00000;
+	customChar[4] = B00000;
+	customChar[5] = B00000;
+	customChar[6] = B00000;
+	customChar[7] = B01000;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(4,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B00000;
+	customChar[1] = B00000;
+	customChar[2] = B00000;
+	customChar[3] = B00000;
+	customChar[4] = B00000;
+	customChar[5] = B00000;
+	customChar[6] = B00010;
+	customChar[7] = B01010;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(5,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B00000;
+	customChar[1] = B00000;
+	customChar[2] = B00000;
+	customChar[3] = B00000;
+	customChar[4] = B00000;
+	customChar[5] = B10000;
+	customChar[6] = B10000;
+	customChar[7] = B10000;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(6,customChar);
+	delay(100);
+	
+	//-------------------------------- defines the graphic
+	customChar[0] = B00000;
+	customChar[1] = B00000;
+	customChar[2] = B00000;
+	customChar[3] = B00000;
+	customChar[4] = B00100;
+	customChar[5] = B10100;
+	customChar[6] = B10100;
+	customChar[7] = B10100;
+	
+	//-------------------------------- Output graphic to LCD
+	_lcd.createChar(7,customChar);
+	delay(100);
+  
+}
@@ -1,131 +1,740 @@
-#ifndef Crane_h
-#define Crane_h
-
-
-#include <inttypes.h>
-#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
-#include "Arduino.h"
-#include "Wire.h"
-#include "LiquidCrystal.h"
-#include "Stepper.h"
-#include "Servo.h"
-#include "SoftwareSerial.h"
-
-class Crane
-{
-	private:
-	
-	
-		//Shared Functions
-		void subscribe(uint8_t index); 												//Subscribed indexes will be pushed next time.
-		int LCM(float n1, float n2, float n3); 										//Returns the LCM of 3 variables. Not efficient
-		uint8_t maX(uint8_t a, uint8_t b); 											//Returns a if a > b, or b if a<=b
-		
-		//Shared Variables									
-		uint8_t _arduinoID; 														//Arduino 1, 2 or 3
-		bool devMode = true; 														//Outputs several things to the LCD screen if in devMode.
-		bool subscribed[16];														//The list to track which elements are subscribed
-	    String _instrBuffer[16];													//The buffer
-		int blueState = 0;															//-1: check (arduino 1), 0: not set, 1: blueOK, 2: blueERR, 3: blueINOP
-		
-		//Private functions arduino 1							
-		int init1(); 																//Initializes the arduino
-		void update1();																//Runs on the loop of arduino 1
-		int verify1();																//Verifies the board
-		
-		//Private variables arduino 1									
-		bool arduino2Verify; 														//True if arduino 1 has received a ping reply from arduino 2
-		bool arduino3Verify; 														//True if arduino 1 has received a ping reply from arduino 3
-		String in; 																	//The string that arduino 1 uses and parses from the HC-06
-		
-		
-		
-		//Private functions arduino 2									
-		int verify2();																//Initializes the arduino
-		void update2();																//Runs on the loop of arduino 2
-		int init2();																//Verifies the stepper motors, and return the ping from arduino 1.
-		
-		//Private variables arduino 2									
-		uint8_t delayStep1 = 0;														//The amount of milliseconds in between each step of stepper motor 1
-		uint8_t delayStep2 = 0;														//The amount of milliseconds in between each step of stepper motor 2
-		uint8_t delayStep3 = 0;														//The amount of milliseconds in between each step of stepper motor 3
-		
-		
-		
-		//Private functions arduino 3									
-		int init3();																//Initializes the arduino
-		void update3();																//Runs on the loop of arduino 3
-		int verify3();																//Verifies LCD, and return the ping from arduino 1.
-		void createCustomChars();													//Creates the custom characters for the LCD
-		void calculatePidValues();													//Calculates the PID values for arduino 1 to use (EXPERIMENTAL W.I.P.)
-		
-		//Private variables arduino 3							
-		int frameConnect = 0;														//A variable used only for the connection graphic on the LCD display.
-		
-		
-		
-	public:							
-		
-		//Public functions arduino 1							
-		String returnHC06Msg();														//Returns the last message sent from the HC-06
-		
-		//Public variables arduino 1							
-		SoftwareSerial hcSerial {3, 2}; 											//The SoftwareSerial object. Used for communications with the HC-06
-		Servo grip;																	//The servo object of the arduino. used to actuate the gripper.
-		float voltage = 11;
-		
-		//Public functions arduino 2							
-		void step(uint8_t stepper, bool direction); 								//Continuously spins stepper in direction
-		void step(uint8_t stepper); 												//Steps the motor once.
-		void stepTo(uint8_t stepper, double positionFrom, double positionTo);
-		double setSpeedOf(uint8_t stepper, float rps); 								//sets the closest mode, and returns the deltaT;
-		void stepSync();
-		
-		//Public variables arduino 2
-		int runTime = 1;															//The runtime of the current stepper "event" (used in the stepSync function)
-		
-		
-		
-		//Public functions arduino 3
-		
-		//Public variables arduino 3
-		String statusString = "ERR";												//The current status of the crane. "ERR" = uninitialized
-		LiquidCrystal _lcd {8, 12, 4, 5, 6, 7};										//The LCD object
-		
-		
-		
-		//Shared Variables							
-		uint8_t  bufferIndex;														//The current index of the buffer
-		uint8_t  bufferLength;														//The pseudo length of the buffer
-		bool boardVerified;															//True if verify(), verify1(), verify2(), verify3() were all completed successfully
-		bool blueConnected = false;													//True if the bluetooth has been connected
-		int stateX;																	//The state of horizontal movement of the crane
-		int stateY;																	//The state of vertical movement of the crane
-		int law = 1;																//0: Direct law, 1: normal law, 2: precision law
-		
-		
-		//Shared Functions							
-		Crane(uint8_t arduinoID);													//The constructor of this class
-		int verify();																//Verifies the components and the board
-		int init();																	//Initializes the components and the board
-		void instruct();															//Unused: Instructs an arduino to do something
-		void monitor();																//Unused: Monitors the situation
-		void update();																//Runs on the loop. For miscellaneous tasks
-		
-		void sendData(uint8_t arduino, byte data);									//Sends a byte of data to an arduino over I2C.
-		void sendData(uint8_t arduino, String data);								//Sends a string of data to an arduino over I2C.
-		
-		String onReceive(int bytes);												//Used to automatically parse things, and returns the parsed string.
-		
-		void flushBuffer();															//Clears the buffer of all data
-		void addToBuffer(String instruction);										//Adds an element to the buffer
-		void pushBuffer(uint8_t arId, uint8_t n);									//Pushes n amount of subscribed strings to an arduino over I2C and removes those items from the buffer
-		void pushBuffer(uint8_t arId);												//Pushes subscribed elements to an arduino over I2C.
-		void removeNFromBuffer(uint8_t n);											//Removes n amount of elements from the buffer
-		int available();															//Returns the amount of unread elements in the buffer.
-		String readBuffer();														//Reads the first unread element, and removes it from the buffer.
-};
-
-
-
+#ifndef Crane_h
+#define Crane_h
+
+
+#include <inttypes.h>
+#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
+#include "Arduino.h"
+#include "Wire.h"
+#include "LiquidCrystal.h"
+#include "Stepper.h"
+#include "Servo.h"
+#include "SoftwareSerial.h"
+
+//-------------------------------- The board this build is for (1, 2 or 3), set with a build flag (-DCRANE_ROLE=2). 0: any board, the Crane(arduinoID) constructor picks it.
+//-------------------------------- The queues are sized for the role, so a build for one board does not carry the buffers of the others (the ATmega328P has 2 KB of RAM)
+#ifndef CRANE_ROLE
+#define CRANE_ROLE 0
+#endif
+
+#ifndef CRANE_TICK_HZ
+#define CRANE_TICK_HZ 20000															//The default frequency of the step engine tick (10 kHz - 40 kHz)
+#endif
+
+#ifndef CRANE_RAMP_LEN
+#define CRANE_RAMP_LEN 32															//The amount of entries in the acceleration ramp table
+#endif
+
+#ifndef CRANE_SEGMENT_COUNT
+#if CRANE_ROLE == 1 || CRANE_ROLE == 3
+#define CRANE_SEGMENT_COUNT 1														//The amount of queued motion segments (must be a power of two). Only arduino 2 moves
+#else
+#define CRANE_SEGMENT_COUNT 4
+#endif
+#endif
+
+#ifndef CRANE_LOOKAHEAD_MS
+#define CRANE_LOOKAHEAD_MS 20														//A queued segment is handed to the step engine this long before the running move starts to decelerate, in milliseconds
+#endif
+
+#ifndef CRANE_JUNCTION_JUMP
+#define CRANE_JUNCTION_JUMP 100														//The largest instant speed change of an axis at a junction between segments, in steps per second
+#endif
+
+#ifndef CRANE_SYNC_WINDOW
+#define CRANE_SYNC_WINDOW 50000UL													//The longest chunk stepSync queues, in microseconds
+#endif
+
+#ifndef CRANE_SYNC_MIN
+#define CRANE_SYNC_MIN 10000UL														//The shortest chunk stepSync queues, in microseconds (loop() has to queue the next chunk in this time)
+#endif
+
+#ifndef CRANE_PULSE_US
+#define CRANE_PULSE_US 2															//The width of a step pulse, in microseconds
+#endif
+
+#ifndef CRANE_RAM_BUDGET
+#define CRANE_RAM_BUDGET 1280														//The most RAM one Crane may take on the ATmega328P, in bytes. Of its 2048, the core, Wire and the serial ports take about 450, the rest is stack
+#endif
+
+//-------------------------------- Stepper driver pins (arduino 2): stepper n has STEP on pin 2+(n-1)*3 (2, 5, 8) and DIR on pin 3+(n-1)*3 (3, 6, 9).
+//-------------------------------- On the ATmega328P these are PD2, PD5, PB0 (STEP) and PD3, PD6, PB1 (DIR), so all pins can be written with one access per port.
+//-------------------------------- The host tests define CRANE_FAST_GPIO themselves, to run this path against simulated port registers
+#if (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)) && !defined(CRANE_FAST_GPIO)
+#define CRANE_FAST_GPIO
+#endif
+#if defined(CRANE_FAST_GPIO)
+#define CRANE_STEP_PORTD(mask) ((((mask) & 1) << 2) | (((mask) & 2) << 4))			//Stepper bit mask -> PORTD bits of the STEP pins
+#define CRANE_STEP_PORTB(mask) (((mask) & 4) >> 2)									//Stepper bit mask -> PORTB bits of the STEP pins
+#define CRANE_DIR_PORTD(mask) ((((mask) & 1) << 3) | (((mask) & 2) << 5))			//Stepper bit mask -> PORTD bits of the DIR pins
+#define CRANE_DIR_PORTB(mask) (((mask) & 4) >> 1)									//Stepper bit mask -> PORTB bits of the DIR pins
+#endif
+
+#ifndef CRANE_AXIS_X
+#define CRANE_AXIS_X 1																//The stepper that moves the trolley (horizontal, X)
+#endif
+
+#ifndef CRANE_AXIS_Z
+#define CRANE_AXIS_Z 2																//The stepper that moves the hoist (vertical, Z)
+#endif
+
+#ifndef CRANE_STEPS_PER_MM
+#define CRANE_STEPS_PER_MM 5.0														//The default calibration of every axis, in steps per millimetre
+#endif
+
+#ifndef CRANE_SELFTEST_STEPS
+#define CRANE_SELFTEST_STEPS 200													//The amount of steps each stepper moves (each way) during the self test of arduino 2
+#endif
+
+#ifndef CRANE_SELFTEST_TIME
+#define CRANE_SELFTEST_TIME 500														//The duration of each self test move, in milliseconds
+#endif
+
+#ifndef CRANE_SELFTEST_CONCURRENT
+#define CRANE_SELFTEST_CONCURRENT 7													//Bit mask of the steppers that can safely be tested at the same time (bit 0: stepper 1)
+#endif
+
+#ifndef CRANE_BOOT_TIMEOUT_2
+#define CRANE_BOOT_TIMEOUT_2 7750													//The longest time arduino 1 waits for the ping reply of arduino 2 (which runs its self test first), in milliseconds
+#endif
+
+#ifndef CRANE_BOOT_TIMEOUT_3
+#define CRANE_BOOT_TIMEOUT_3 7750													//The longest time arduino 1 waits for the ping reply of arduino 3, in milliseconds
+#endif
+
+#ifndef CRANE_BOOT_BLUE_MS
+#define CRANE_BOOT_BLUE_MS 500														//The longest time arduino 1 waits for the reply of the HC-06 to AT+VERSION, in milliseconds
+#endif
+
+#ifndef CRANE_BOOT_LED_MS
+#define CRANE_BOOT_LED_MS 5000														//How long the verification result is shown on the status leds, in milliseconds
+#endif
+
+#define CRANE_BOOT_SERVO_MS 1000													//The time in between the positions of the gripper servo check, in milliseconds
+
+//-------------------------------- The phases of the boot sequence of arduino 1 (index of bootTrace, bit n of bootPending)
+#define CRANE_BOOT_PEER2 0															//The ping reply of arduino 2 came in (or timed out)
+#define CRANE_BOOT_PEER3 1															//The ping reply of arduino 3 came in (or timed out)
+#define CRANE_BOOT_BLUE 2															//The HC-06 replied to AT+VERSION (or timed out)
+#define CRANE_BOOT_SERVO 3															//The gripper servo check is done
+#define CRANE_BOOT_RESULT 4															//The verification result has been sent to arduino 2 and 3
+#define CRANE_BOOT_LED 5															//The verification result has been shown on the status leds
+#define CRANE_BOOT_PHASES 6															//The amount of phases
+
+#ifndef CRANE_ECHO_CYCLE_MS
+#define CRANE_ECHO_CYCLE_MS 60														//The shortest time in between two triggers of the range sensor, in milliseconds (the HC-SR04 needs 60)
+#endif
+
+#define CRANE_ECHO_TICK_HZ 20000													//How often the echo pin is sampled while a measurement runs (Timer2 on AVR)
+#define CRANE_ECHO_MAX_US 25000														//The longest valid echo, in microseconds (about 4.3 m). Longer means nothing was in range
+#define CRANE_ECHO_LATE_US (3 * 1000000UL / CRANE_ECHO_TICK_HZ)						//A tick this long after the one before came late (the interrupts were off): an edge it sees is thrown away (150 us, about 26 mm)
+
+//-------------------------------- The filter of the range sensor: a rolling median, then an alpha-beta filter for the height and vertical velocity (see filterSample)
+#ifndef CRANE_MEDIAN_LEN
+#define CRANE_MEDIAN_LEN 5															//The amount of samples the rolling median looks at (odd)
+#endif
+#ifndef CRANE_FILTER_ALPHA
+#define CRANE_FILTER_ALPHA 128														//The height gain of the alpha-beta filter, in 1/256 (128: 0.5)
+#endif
+#ifndef CRANE_FILTER_BETA
+#define CRANE_FILTER_BETA 32														//The velocity gain of the alpha-beta filter, in 1/256 (32: 0.125)
+#endif
+#define CRANE_FILTER_RESET_MS 500													//After a gap this long without samples, the filter starts over from the next sample, in milliseconds
+#define CRANE_FILTER_MAX_V 10000													//The highest velocity the filter reports, in millimetres per second
+
+#define CRANE_STEPS_PER_REV 200														//The amount of (full) steps per rotation of the stepper motors
+#define CRANE_PERIOD_CENTI ((100000000UL / CRANE_STEPS_PER_REV) << 8)				//The step period at 0.01 rotations per second, in microseconds (Q24.8)
+
+//-------------------------------- The default motion limits of each stepper, in steps per second (speed) and steps per second^2 (acceleration).
+//-------------------------------- The ramp tables for these limits are generated at compile time and stored in flash.
+#ifndef CRANE_SPEED_1
+#define CRANE_SPEED_1 1000
+#endif
+#ifndef CRANE_SPEED_2
+#define CRANE_SPEED_2 1000
+#endif
+#ifndef CRANE_SPEED_3
+#define CRANE_SPEED_3 1000
+#endif
+#ifndef CRANE_ACCEL_1
+#define CRANE_ACCEL_1 2000
+#endif
+#ifndef CRANE_ACCEL_2
+#define CRANE_ACCEL_2 2000
+#endif
+#ifndef CRANE_ACCEL_3
+#define CRANE_ACCEL_3 2000
+#endif
+
+//-------------------------------- The binary I2C frames: [opcode][sequence number][payload, little endian][CRC-8]
+//-------------------------------- Every opcode has the top bit set, so a frame can never be mistaken for a text message. Data starting with such a byte is only taken for a frame if its length and CRC-8 match
+#define CRANE_OP_PING 0x80															//Ping. No payload
+#define CRANE_OP_OK 0x81															//Ping reply. Payload: the arduino ID (uint8)
+#define CRANE_OP_VERIFY_OK 0x82														//The board has been verified. No payload
+#define CRANE_OP_CONNECTED 0x83														//The bluetooth has been connected. No payload
+#define CRANE_OP_BLUE 0x84															//The state of the bluetooth module. Payload: blueState (uint8)
+#define CRANE_OP_STEP 0x85															//Speed command. Payload: stepper (uint8), speed in 0.01 rotations per second (int16)
+#define CRANE_OP_MOVE 0x86															//Move command. Payload: x, z in 0.01 millimetres (int32, int32)
+#define CRANE_OP_SELF 0x87															//Self test result of arduino 2 (a smoke test of the step engine). Payload: stepperTest (uint8)
+#define CRANE_OP_COUNT 8															//The amount of opcodes
+#define CRANE_FRAME_MAX 11															//The length of the longest frame, in bytes
+#define CRANE_OP_BATCH 0xFF															//Marks a batch of messages: [CRANE_OP_BATCH][length][message][length][message]... Never a frame opcode
+#define CRANE_WIRE_BUFFER 32														//The size of the Wire buffer: the most bytes one I2C transaction can carry
+#define CRANE_OP_USER 0xA0															//The first application opcode. Frames: [opcode][seq][payload, any length][CRC-8] (see onCommand)
+#define CRANE_USER_COMMANDS 16														//The amount of application opcodes
+
+//-------------------------------- The instruction buffer: a ring of fixed length slots, so it never touches the heap
+#ifndef CRANE_BUFFER_SLOTS
+#define CRANE_BUFFER_SLOTS 16														//The amount of entries in the instruction buffer (must be a power of two, 32 at most)
+#endif
+#if CRANE_BUFFER_SLOTS <= 8
+typedef uint8_t CraneSlotMask;														//One bit per slot of the instruction buffer
+#elif CRANE_BUFFER_SLOTS <= 16
+typedef uint16_t CraneSlotMask;
+#else
+typedef uint32_t CraneSlotMask;
+#endif
+#ifndef CRANE_SLOT_LEN
+#define CRANE_SLOT_LEN 15															//The longest entry of the instruction buffer, in bytes
+#endif
+#ifndef CRANE_BUS_STATS
+#define CRANE_BUS_STATS 1															//1: measure the latency and throughput of the I2C bus (see printBusStats), 0: leave it out
+#endif
+#define CRANE_BUS_BUCKETS 8															//The amount of buckets of the bus latency histograms (bucket k: less than 128 << k microseconds)
+#ifndef CRANE_TELEMETRY
+#define CRANE_TELEMETRY 1															//1: record telemetry samples and send them over Serial as binary frames (see processTelemetry), 0: leave it out
+#endif
+#ifndef CRANE_TM_SLOTS
+#define CRANE_TM_SLOTS 8															//The amount of samples the telemetry ring holds until they are sent (must be a power of two)
+#endif
+#ifndef CRANE_TM_INTERVAL_MS
+#define CRANE_TM_INTERVAL_MS 50														//The default time in between two telemetry frames, in milliseconds (see telemetryInterval)
+#endif
+#define CRANE_TM_BATCH 6															//The most samples one telemetry frame carries
+#define CRANE_TM_SYNC 0x7E															//Starts a telemetry frame: [CRANE_TM_SYNC][count][count samples of 6 bytes][CRC-8]
+#define CRANE_TM_FRAME_MAX (3 + 6 * CRANE_TM_BATCH)									//The length of the longest telemetry frame, in bytes
+
+//-------------------------------- The types of telemetry samples (arg and value of each)
+#define CRANE_TM_DISTANCE 1															//The filtered distance of the range sensor. Value: millimetres
+#define CRANE_TM_VELOCITY 2															//The vertical velocity from the range sensor. Value: millimetres per second
+#define CRANE_TM_RECEIVED 3															//A transmission was received over I2C. Value: bytes
+#define CRANE_TM_SEND 4																//Data was queued for an arduino. Arg: arduino, value: bytes
+#define CRANE_TM_FRAME 5															//A frame was queued for an arduino. Arg: arduino, value: opcode
+#define CRANE_TM_SUBSCRIBE 6														//A buffer entry was subscribed. Value: index
+#define CRANE_TM_BUFFER 7															//An entry was added to the instruction buffer. Arg: slot, value: bytes
+#define CRANE_TM_PUSH 8																//Buffer entries were pushed to an arduino. Arg: arduino, value: entries
+#define CRANE_TM_DROPPED 9															//A received message was dropped. Arg: 0 application frame (no command), 2 data (buffer full)
+#define CRANE_TM_GAVE_UP 10															//A message was given up after CRANE_TX_ATTEMPTS. Arg: arduino
+
+#ifndef CRANE_RX_SLOTS
+#define CRANE_RX_SLOTS 2															//The amount of transmissions the receive queue holds until update() handles them (must be a power of two). Speed commands bypass it
+#endif
+#ifndef CRANE_TX_SLOTS
+#if CRANE_ROLE == 1
+#define CRANE_TX_SLOTS 4															//The amount of messages the transmit queue holds (shared by all destinations). Arduino 1 talks to both others
+#else
+#define CRANE_TX_SLOTS 2
+#endif
+#endif
+#define CRANE_TX_ATTEMPTS 5															//The amount of times a message is sent before it is given up, if it is not acknowledged (a receiver with a full queue refuses until its update())
+#define CRANE_TX_RETRY_MS 5															//The time in between attempts, in milliseconds
+#if CRANE_ROLE == 0 || CRANE_ROLE == 1
+#define CRANE_BT_BUFFER 32															//The longest message from the HC-06, in bytes. Only arduino 1 has one
+#else
+#define CRANE_BT_BUFFER 8
+#endif
+#define CRANE_BT_SYNC 0xA5															//Starts a binary frame from the HC-06: [CRANE_BT_SYNC][length][payload, ending in its CRC-8]
+#define CRANE_BT_GAP_MS 20															//A message without delimiter from the HC-06 ends after this much silence, in milliseconds
+#define CRANE_BT_LINE 1																//feedHC06: a text line is complete
+#define CRANE_BT_FRAME 2															//feedHC06: a binary frame is complete
+#define CRANE_JOY_STATE 0x40														//Joystick frame: the full controller state. Payload: [kind | seq][axes and law][buttons][CRC-8]
+#define CRANE_JOY_HOLD 0x80															//Joystick frame: nothing changed since state 'seq'. Payload: [kind | seq][CRC-8]
+#define CRANE_JOY_FRAME_MAX 6														//The length of the longest joystick frame on the wire (with CRANE_BT_SYNC and the length byte), in bytes
+#ifndef CRANE_JOY_REFRESH
+#define CRANE_JOY_REFRESH 8														//The full state is sent again after this many hold frames, so a lost state frame is recovered
+#endif
+//-------------------------------- When the buffer is full, new entries are rejected. Define CRANE_BUFFER_DROP_OLDEST to overwrite the oldest entry instead
+
+/// Square root for compile time use (Newton's method)
+/// 
+///
+constexpr double craneSqrt(double x, double guess, uint8_t n)
+{
+	return n == 0 ? guess : craneSqrt(x, (guess + x / guess) / 2, n - 1);
+}
+
+constexpr double craneSqrt(double x)
+{
+	return x <= 0 ? 0 : craneSqrt(x, x > 1 ? x : 1, 40);
+}
+
+/// The time (in microseconds) it takes to travel 'n' steps from standstill at a constant acceleration (steps/s^2)
+/// 
+///
+constexpr double craneRampTime(uint32_t accel, uint32_t n)
+{
+	return craneSqrt(2e12 * n / accel);
+}
+
+/// The amount of steps it takes to reach 'speed' (steps/s) from standstill at a constant acceleration (steps/s^2)
+/// 
+///
+constexpr uint32_t craneRampSteps(uint32_t accel, uint32_t speed)
+{
+	return ((uint64_t)speed * speed + 2 * accel - 1) / (2 * accel);
+}
+
+/// The amount of steps each table entry has to cover, as a power of two, so a ramp of 'steps' steps fits in CRANE_RAMP_LEN entries
+/// 
+///
+constexpr uint8_t craneRampShift(uint32_t steps, uint8_t shift = 0)
+{
+	return ((steps - 1) >> shift) < CRANE_RAMP_LEN ? shift : craneRampShift(steps, shift + 1);
+}
+
+/// The average interval (in microseconds) of the steps from 'start' up to 'end', clamped to 16 bits
+/// 
+///
+constexpr uint16_t craneRampAverage(uint32_t accel, uint32_t start, uint32_t end)
+{
+	return (craneRampTime(accel, end) - craneRampTime(accel, start)) / (end - start) > 65535 ? 65535
+		: (uint16_t)((craneRampTime(accel, end) - craneRampTime(accel, start)) / (end - start));
+}
+
+/// Ramp table entry 'k': the average interval of the steps it covers. Entries past the end of the ramp repeat the last one
+/// 
+///
+constexpr uint16_t craneRampEntry(uint32_t accel, uint32_t steps, uint8_t shift, uint32_t k)
+{
+	return (k << shift) >= steps ? craneRampEntry(accel, steps, shift, (steps - 1) >> shift)
+		: craneRampAverage(accel, k << shift, ((k + 1) << shift) < steps ? ((k + 1) << shift) : steps);
+}
+
+template<uint16_t... I> struct CraneIndices {};
+template<uint16_t N, uint16_t... I> struct CraneMakeIndices : CraneMakeIndices<N - 1, N - 1, I...> {};
+template<uint16_t... I> struct CraneMakeIndices<0, I...> { typedef CraneIndices<I...> type; };
+
+/// The trapezoidal acceleration ramp of a stepper, from standstill up to 'Speed' (steps/s) at 'Accel' (steps/s^2)
+/// The table is generated by the compiler and lives in flash (read it with pgm_read_word). Entry k holds the step interval in microseconds of ramp steps (k << shift) and up
+template<uint32_t Accel, uint32_t Speed, class Indices = typename CraneMakeIndices<CRANE_RAMP_LEN>::type> struct CraneRamp;
+template<uint32_t Accel, uint32_t Speed, uint16_t... I> struct CraneRamp<Accel, Speed, CraneIndices<I...> >
+{
+	static constexpr uint32_t steps = craneRampSteps(Accel, Speed);				//The amount of steps it takes to reach the speed
+	static constexpr uint8_t shift = craneRampShift(steps);							//Each entry covers (1 << shift) steps
+	static const uint16_t table[CRANE_RAMP_LEN];									//The step intervals, in microseconds
+};
+template<uint32_t Accel, uint32_t Speed, uint16_t... I> const uint16_t CraneRamp<Accel, Speed, CraneIndices<I...> >::table[CRANE_RAMP_LEN] PROGMEM = { craneRampEntry(Accel, steps, shift, I)... };
+
+typedef CraneRamp<CRANE_ACCEL_1, CRANE_SPEED_1> CraneRamp1;							//The compile time ramp of stepper 1
+typedef CraneRamp<CRANE_ACCEL_2, CRANE_SPEED_2> CraneRamp2;							//The compile time ramp of stepper 2
+typedef CraneRamp<CRANE_ACCEL_3, CRANE_SPEED_3> CraneRamp3;							//The compile time ramp of stepper 3
+
+/// A move loaded into the step engine
+/// Intervals are in microseconds (Q24.8). Ramp positions count steps from standstill in the ramp table of the dominant axis
+struct CraneMove
+{
+	uint32_t steps[3];																//The absolute amount of steps each axis takes
+	uint8_t dir;																	//Bit n set: stepper n+1 moves forward
+	uint32_t events;																//The amount of steps of the dominant axis
+	const uint16_t* ramp;															//The ramp table of the dominant axis. 0: constant interval
+	bool flash;																		//True if the ramp table is stored in flash
+	uint8_t shift;																	//Each ramp table entry covers (1 << shift) steps
+	uint32_t accelFrom;																//The ramp position at the start of the move (the entry speed)
+	uint32_t accelSteps;															//The amount of accelerating steps
+	uint32_t decelTo;																//The ramp position at the end of the move (the exit speed)
+	uint32_t decelSteps;															//The amount of decelerating steps
+	uint32_t interval;																//The interval in between the ramps
+};
+
+/// A motion segment waiting in the look-ahead queue
+/// Speeds are in steps per second of the dominant axis
+struct CraneSegment
+{
+	int32_t steps[3];																//The signed amount of steps each axis takes
+	uint32_t events;																//The amount of steps of the dominant axis
+	uint8_t axis;																	//The dominant axis (0, 1, 2)
+	float nominal;																	//The cruise speed
+	float maxEntry;																	//The highest speed allowed at the junction with the previous segment
+	float entry;																	//The planned entry speed
+};
+
+/// A transmission received over I2C, waiting in the receive queue
+/// 
+struct CraneReceived
+{
+	uint8_t length;																	//The amount of bytes received
+	uint8_t data[CRANE_WIRE_BUFFER];												//The bytes (a message, or a batch of messages)
+#if CRANE_BUS_STATS
+	uint32_t time;																	//When it was received (micros), for the receive latency
+#endif
+};
+
+/// A message waiting in the transmit queue
+/// 
+struct CraneOutgoing
+{
+	uint8_t arduino;																//The destination address. 0: free slot
+	uint8_t length;																	//The amount of bytes
+	uint8_t attempts;																//The amount of failed attempts so far
+	uint8_t order;																	//When it was queued (wraps around), to keep the order per destination
+	uint16_t retryAt;																//When it can be sent (the lower 16 bits of millis)
+	uint8_t data[CRANE_WIRE_BUFFER];												//The bytes
+};
+
+/// Statistics of one direction of the I2C bus
+/// Transmit latency: the time a transaction takes. Receive latency: the time from the interrupt until update() handled the message
+struct CraneBusStats
+{
+	uint32_t messages;																//The amount of transactions
+	uint32_t bytes;																	//The amount of bytes
+	uint32_t micros;																//The total latency, in microseconds
+	uint32_t maxMicros;																//The worst latency, in microseconds
+	uint16_t failures;																//The amount of transactions that were not acknowledged (transmit only)
+	uint16_t histogram[CRANE_BUS_BUCKETS];											//The amount of transactions per latency bucket
+};
+
+/// The state of the joystick controller, as sent over the HC-06
+/// The encoder keeps the last state it sent in here, the receiver the last state it applied
+struct CraneJoystick
+{
+	int8_t x;																		//The horizontal axis (-4 to 3)
+	int8_t y;																		//The vertical axis (-4 to 3)
+	uint8_t law;																	//The law of operation (0 to 3)
+	uint8_t buttons;																//Bit n set: button n is pressed
+	uint8_t seq;																	//The sequence number of the state (1 to 63). 0: nothing sent yet
+	uint8_t holds;																	//The amount of hold frames since the state was sent
+};
+
+/// The state of the distance filter (see filterSample)
+/// Height and velocity are fixed point with 8 fractional bits, so the filter runs on every sample without floats
+struct CraneFilter
+{
+	uint16_t window[CRANE_MEDIAN_LEN];												//The last samples, in millimetres (a ring)
+	uint8_t count;																	//The amount of samples in the window
+	uint8_t next;																	//The slot the next sample goes into
+	int32_t height;																	//The estimated height, in millimetres (Q24.8)
+	int32_t velocity;																//The estimated vertical velocity, in millimetres per second (Q24.8)
+	uint32_t time;																	//When the last sample was taken (millis)
+};
+
+/// A telemetry sample, waiting in the telemetry ring
+/// On the wire: type, arg, time (little endian), value (little endian)
+struct CraneSample
+{
+	uint8_t type;																	//One of the CRANE_TM_ types
+	uint8_t arg;																	//Depends on the type (see the CRANE_TM_ types)
+	uint16_t time;																	//When it was recorded (the lower 16 bits of millis)
+	int16_t value;																	//Depends on the type (see the CRANE_TM_ types)
+};
+
+class Crane;
+typedef void (*CraneCommand)(Crane& crane, const uint8_t* payload, uint8_t length);	//The command of an application opcode. Gets the payload of the frame, straight from the receive buffer
+typedef void (*CraneBlueHandler)(Crane& crane, const uint8_t* data, uint8_t length);	//Handles a complete message from the HC-06. Gets the message, straight from the parser buffer
+
+/// An entry of the instruction buffer
+/// Holds text or a binary frame, and is not null terminated
+struct CraneSlot
+{
+	uint8_t length;																	//The amount of bytes used
+	uint8_t data[CRANE_SLOT_LEN];													//The contents
+};
+
+class Crane
+{
+	private:
+	
+	
+		//Shared Functions
+		void subscribe(uint8_t index); 												//Subscribed indexes will be pushed next time.
+		uint32_t LCM(uint32_t a, uint32_t b); 										//Returns the exact LCM of two periods, or 0 if it is longer than CRANE_SYNC_WINDOW
+		uint8_t maX(uint8_t a, uint8_t b); 											//Returns a if a > b, or b if a<=b
+		void onFrame(uint8_t opcode, int32_t a, int32_t b);							//Applies a received binary frame
+		void onMessage(const uint8_t* data, uint8_t length);						//Handles one received message (a frame or text)
+		static bool isBatch(const uint8_t* data, uint8_t length);					//Returns true if a transmission is a batch of messages (see CRANE_OP_BATCH)
+		bool coalesceSpeeds(const uint8_t* data, uint8_t length);					//Takes a transmission of STEP frames into the speed slots (arduino 2). Returns false if it is something else
+		uint8_t transmit(uint8_t arduino, const uint8_t* data, uint8_t length);		//Sends bytes in one I2C transaction, and returns the status of Wire.endTransmission. All messages are sent through here
+		CraneOutgoing _txQueue[CRANE_TX_SLOTS] = {};								//The transmit queue
+		uint8_t _txOrder = 0;														//The order of the next queued message
+		void waitBus(unsigned long ms);												//Waits, while handling received messages and sending queued ones
+		void queueTransmit(uint8_t arduino, const uint8_t* data, uint8_t length);	//Queues bytes for an I2C address. Waits for room if the queue is full
+		void skipSent();															//Moves the read counter past entries that have already been pushed
+		void sendBatch(uint8_t arduino, const uint8_t* batch, uint8_t length, uint8_t count);	//Sends a batch of 'count' messages. A batch of one is sent as a plain message
+		
+		//Shared Variables									
+		uint8_t _arduinoID; 														//Arduino 1, 2 or 3
+		bool devMode = true; 														//Outputs several things to the LCD screen if in devMode.
+		CraneSlotMask subscribed = 0;												//Bit n set: slot n is subscribed
+		uint8_t _bufferSent = 0;													//The amount of unread entries that have already been pushed (skipped when reading)
+	    CraneSlot _instrBuffer[CRANE_BUFFER_SLOTS];									//The buffer (a ring, see bufferIndex and bufferLength)
+		int blueState = 0;															//-1: check (arduino 1), 0: not set, 1: blueOK, 2: blueERR, 3: blueINOP
+		uint8_t _frameSeq = 0;														//The sequence number of the next frame sent
+		CraneReceived _rxQueue[CRANE_RX_SLOTS];										//The receive queue: filled by onReceive (interrupt), emptied by processReceived
+		volatile uint8_t _rxHead = 0;												//The amount of transmissions ever queued (wraps around). Only written by onReceive
+		volatile uint8_t _rxTail = 0;												//The amount of transmissions ever handled (wraps around). Only written by processReceived
+		volatile int16_t _speedIn[3];												//The newest received speed of each stepper, in 0.01 rotations per second (arduino 2)
+		volatile uint8_t _speedInPending = 0;										//Bit n set: _speedIn[n] has not been applied yet
+		int16_t _speedOut[3];														//The newest speed set for each stepper of arduino 2 (arduino 1)
+		uint8_t _speedOutPending = 0;												//Bit n set: _speedOut[n] has not been sent yet
+		CraneCommand _commands[CRANE_USER_COMMANDS] = {};							//The registered command of each application opcode (index: opcode - CRANE_OP_USER)
+#if CRANE_TELEMETRY
+		CraneSample _tmRing[CRANE_TM_SLOTS];										//The telemetry ring: filled by record, emptied by processTelemetry
+		uint8_t _tmHead = 0;														//The amount of samples ever recorded (wraps around)
+		uint8_t _tmTail = 0;														//The amount of samples ever sent (wraps around)
+		unsigned long _tmLast = 0;													//When the last telemetry frame was sent (millis)
+#endif
+		
+		//Private functions arduino 1							
+		int init1(); 																//Initializes the arduino
+		void update1();																//Runs on the loop of arduino 1
+		int verify1();																//Verifies the board
+		void updateBoot();															//Advances the boot sequence. Called from update1()
+		bool updateEcho();															//Triggers the range sensor when it is due, and collects its echo. Returns true if a new distance came in
+		
+		//Private variables arduino 1									
+		bool arduino2Verify; 														//True if arduino 1 has received a ping reply from arduino 2
+		bool arduino3Verify; 														//True if arduino 1 has received a ping reply from arduino 3
+		String in; 																	//The string that arduino 1 uses and parses from the HC-06
+		uint8_t readHC06();															//Reads from the HC-06 until a message is complete. Returns its type (0: none yet)
+		void resyncHC06();															//Drops a broken frame, and feeds its bytes from the next sync byte again
+		uint8_t _btBuffer[CRANE_BT_BUFFER];											//The message from the HC-06 being received
+		uint8_t _btLength = 0;														//The amount of bytes in _btBuffer
+		uint8_t _btState = 0;														//0: text, 1: frame length next, 2: frame payload, 3: skipping a line that is too long
+		uint8_t _btExpected = 0;													//The length of the frame being received
+		uint8_t _btReplay = 0;														//The next byte of _btBuffer to feed to the parser again (after a broken frame, see resyncHC06)
+		uint8_t _btReplayEnd = 0;													//The end of the bytes to feed again
+		bool _btDone = false;														//True if _btBuffer holds a complete message
+		unsigned long _btLastByte = 0;												//When the last byte came in (millis)
+		CraneBlueHandler _btOnLine = 0;												//Handles complete text lines
+		CraneBlueHandler _btOnFrame = 0;											//Handles complete binary frames
+		CraneJoystick _joystick = {};												//The last joystick state applied
+		unsigned long _bootStart = 0;												//When the boot sequence started (millis)
+		uint8_t _bootServo = 0;														//The amount of gripper servo positions reached so far
+		volatile uint8_t _echoState = 0;											//0: idle, 1: waiting for the echo, 2: timing the echo, 3: echo done, 4: an edge was seen late
+		volatile uint16_t _echoLast = 0;											//When the echo pin was last sampled (micros, the low 16 bits)
+		volatile uint32_t _echoRise = 0;											//When the echo started (micros)
+		volatile uint32_t _echoWidth = 0;											//The length of the last echo, in microseconds
+		unsigned long _echoTrigger = 0;												//When the range sensor was last triggered (millis)
+		uint16_t _distance = 0;														//The latest valid distance, in millimetres. 0: none yet
+		unsigned long _distanceTime = 0;											//When the latest valid distance was measured (millis)
+		CraneFilter _filter = {};													//The filter of the range sensor
+		
+		
+		
+		//Private functions arduino 2									
+		int verify2();																//Initializes the arduino
+		void update2();																//Runs on the loop of arduino 2
+		void updateSelfTest();														//Advances the stepper self test by one state. Called from update2()
+		int init2();																//Verifies the stepper motors, and return the ping from arduino 1.
+		uint32_t prepareMove(CraneMove& move, const int32_t* steps);				//Fills in the steps and directions of a move, returns the amount of dominant axis steps
+		bool planMove(const int32_t* steps, float entry, float nominal, float exit);	//Plans a ramped move into the next slot of the step engine. Returns false if the slot is taken
+		void loadMove();															//Starts the move in the next slot. Called from tick()
+		uint32_t intervalOf(uint32_t event);										//Returns the interval before step 'event' of the current move
+		void buildRamp(uint8_t stepper);											//Fills the RAM ramp table of stepper with its acceleration from standstill up to its maximum speed
+		uint32_t rampIndexOf(uint8_t stepper, float speed);							//Returns the ramp position at which 'speed' (steps/s) is reached
+		uint16_t rampAt(uint8_t stepper, uint8_t entry);							//Returns entry 'entry' of the ramp table of stepper (flash or RAM)
+		float rampStep(float& v, float& a, float vMax, float aMax, float jMax);		//Advances a velocity profile by one step, returns the duration of that step in seconds
+		float junctionSpeed(const CraneSegment& from, const CraneSegment& to);		//Returns the highest speed at which segment 'from' can blend into segment 'to'
+		void planSegments();														//Recalculates the entry speeds of all queued segments (look-ahead)
+		void popSegment();															//Hands the first queued segment to the step engine
+		uint32_t decelIn();															//Returns the time until the running move starts to decelerate, in milliseconds (0: idle, or decelerating)
+		
+		//Private variables arduino 2									
+		uint32_t _stepPeriod[3] = {0, 0, 0};										//The time in between each step of each stepper motor, in microseconds (Q24.8). 0: disabled
+		uint8_t _speedDir = 0;														//Bit n set: stepper n+1 runs forward (set by setSpeedOf)
+		uint32_t _syncCarry[3] = {0, 0, 0};											//The time (in Q24.8 microseconds) each stepper has left over from the previous stepSync chunk
+		
+		//Private variables arduino 2 (step engine, shared with the tick interrupt)
+		volatile bool _moving = false;												//True while the step engine is executing a move
+		volatile bool _nextReady = false;											//True if a move is waiting in the next slot
+		CraneMove _move;															//The move being executed
+		CraneMove _next;															//The move that starts when the current one is done
+		uint32_t _tickPeriod = 0;													//The time between two ticks, in microseconds (Q24.8)
+		uint32_t _moveInterval = 0;													//The time between two steps of the dominant axis, in microseconds (Q24.8)
+		uint32_t _movePhase = 0;													//The time elapsed since the last step of the dominant axis, in microseconds (Q24.8)
+		uint32_t _moveEvent = 0;													//The amount of dominant axis steps already taken in the current move
+		int32_t _bresErr[3];														//The Bresenham error terms of each axis
+		const uint16_t* _ramp[3] = {CraneRamp1::table, CraneRamp2::table, CraneRamp3::table};	//The ramp table of each axis: compile time (flash), or built by setLimitsOf (RAM, allocated by the first call)
+		uint8_t _rampFlash = 7;														//Bit n set: the ramp table of stepper n+1 is in flash
+		uint32_t _rampSteps[3] = {CraneRamp1::steps, CraneRamp2::steps, CraneRamp3::steps};	//The amount of steps it takes each axis to reach its maximum speed
+		uint8_t _rampShift[3] = {CraneRamp1::shift, CraneRamp2::shift, CraneRamp3::shift};	//Each ramp table entry covers (1 << _rampShift) steps
+		
+		//Private variables arduino 2 (look-ahead queue)
+		CraneSegment _segments[CRANE_SEGMENT_COUNT];								//The queued motion segments (ring buffer)
+		uint8_t _segHead = 0;														//The index of the first queued segment
+		uint8_t _segTail = 0;														//The index after the last queued segment
+		float _headEntry = 0;														//The entry speed of the first queued segment, fixed by the move before it
+		int32_t _target[3] = {0, 0, 0};												//The position (in steps) each axis has once all queued moves are done
+		
+		//Private variables arduino 2 (self test)
+		uint8_t _testState = 0;														//0: idle, 1: start the next group, 2: moving forward, 3: moving back, 4: report
+		uint8_t _testLeft = 0;														//Bit mask of the steppers that still have to be tested
+		uint8_t _testGroup = 0;														//Bit mask of the steppers being tested right now
+		unsigned long _testTime = 0;												//The time (millis) the current self test move started
+		
+		//Private variables arduino 2 (positions)
+		volatile int32_t _position[3] = {0, 0, 0};									//The position of each axis in steps, counted by the step engine
+		float _stepsPerMm[3] = {CRANE_STEPS_PER_MM, CRANE_STEPS_PER_MM, CRANE_STEPS_PER_MM};	//The calibration of each axis, in steps per millimetre
+		
+		//Private variables arduino 2 (motion limits)
+		float _maxVelocity[3] = {(float)CRANE_SPEED_1 / CRANE_STEPS_PER_REV, (float)CRANE_SPEED_2 / CRANE_STEPS_PER_REV, (float)CRANE_SPEED_3 / CRANE_STEPS_PER_REV};	//The maximum speed of each stepper, in rotations per second
+		float _maxAccel[3] = {(float)CRANE_ACCEL_1 / CRANE_STEPS_PER_REV, (float)CRANE_ACCEL_2 / CRANE_STEPS_PER_REV, (float)CRANE_ACCEL_3 / CRANE_STEPS_PER_REV};	//The maximum acceleration of each stepper, in rotations per second^2
+		float _maxJerk[3] = {0, 0, 0};												//The maximum jerk of each stepper, in rotations per second^3. 0: trapezoidal profile
+		
+		
+		
+		//Private functions arduino 3									
+		int init3();																//Initializes the arduino
+		void update3();																//Runs on the loop of arduino 3
+		int verify3();																//Verifies LCD, and return the ping from arduino 1.
+		void createCustomChars();													//Creates the custom characters for the LCD
+		void calculatePidValues();													//Calculates the PID values for arduino 1 to use (EXPERIMENTAL W.I.P.)
+		
+		//Private variables arduino 3							
+		int frameConnect = 0;														//A variable used only for the connection graphic on the LCD display.
+		
+		
+		
+	public:							
+		
+		//Public functions arduino 1							
+		String returnHC06Msg();														//Returns the next complete message sent from the HC-06 ("" if there is none)
+		uint8_t feedHC06(uint8_t c);												//Feeds one byte into the HC-06 parser. Returns CRANE_BT_LINE or CRANE_BT_FRAME when a message is complete
+		void pollHC06();															//Hands the complete HC-06 messages to the registered handlers. Called by update()
+		void onBlueLine(CraneBlueHandler handler);									//Registers the handler of text lines from the HC-06
+		void onBlueFrame(CraneBlueHandler handler);									//Registers the handler of binary frames from the HC-06
+		uint16_t blueOverflows = 0;													//The amount of HC-06 messages dropped because they did not fit the buffer, or were broken frames
+		static void joystickFrame(Crane& crane, const uint8_t* data, uint8_t length);	//Applies a joystick frame to stateX, stateY, law and buttons. Register it with onBlueFrame
+		static uint8_t encodeJoystick(uint8_t* frame, CraneJoystick& sent, int8_t x, int8_t y, uint8_t law, uint8_t buttons);	//Writes the next joystick frame (up to CRANE_JOY_FRAME_MAX bytes) and returns its length
+		static bool decodeJoystick(const uint8_t* payload, uint8_t length, CraneJoystick& state);	//Reads a joystick frame into 'state'. Returns false if it is malformed, or a hold frame of a state that was missed
+		uint16_t joystickErrors = 0;												//The amount of joystick frames rejected
+		unsigned long joystickTime = 0;												//When the last joystick frame was applied (millis)
+		void printBootTrace();														//Prints how long each phase of the boot sequence took
+		uint16_t latestDistance(unsigned long* time = 0);							//Returns the latest valid distance of the range sensor in millimetres (0: none yet), and when it was measured (millis)
+		uint16_t filteredDistance(int16_t* velocity = 0);							//Returns the filtered distance in millimetres (0: none yet), and the vertical velocity in millimetres per second
+		static void filterSample(CraneFilter& filter, uint16_t mm, uint32_t ms);	//Runs one sample (in millimetres, taken at 'ms') through the distance filter
+		void echoTick();															//Samples the echo pin of the range sensor. Called from the timer interrupt
+		uint16_t echoMisses = 0;													//The amount of measurements without a valid echo
+		uint16_t echoLate = 0;														//The amount of echoes thrown away because an edge was seen late (see CRANE_ECHO_LATE_US)
+		
+		//Public variables arduino 1							
+		SoftwareSerial hcSerial {3, 2}; 											//The SoftwareSerial object. Used for communications with the HC-06
+		Servo grip;																	//The servo object of the arduino. used to actuate the gripper.
+		float voltage = 11;
+		uint8_t bootPending = 0;													//Bit n set: boot phase n (CRANE_BOOT_ constants) has not finished yet. 0: the boot sequence is done
+		uint16_t bootTrace[CRANE_BOOT_PHASES] = {};									//When each boot phase finished, in milliseconds since verify()
+		
+		//Public functions arduino 2							
+		void step(uint8_t stepper, bool direction); 								//Continuously spins stepper in direction
+		void step(uint8_t stepper); 												//Steps the motor once.
+		void pulseSteps(uint8_t mask);												//Steps every stepper in the bit mask once, at the same time (bit 0: stepper 1)
+		void setDirections(uint8_t mask, uint8_t dir);								//Sets the DIR pins of the steppers in 'mask' to the matching bits of 'dir'
+		bool stepTo(uint8_t stepper, double positionFrom, double positionTo);		//Moves stepper from positionFrom to positionTo (in rotations) with an acceleration profile. Returns false if another move is waiting
+		bool setLimitsOf(uint8_t stepper, float maxRps, float maxAccel, float maxJerk);	//Sets the maximum speed, acceleration and jerk used by stepTo. Returns false if there is no memory for its ramp table
+		bool queueMove(int32_t steps1, int32_t steps2, int32_t steps3, float rps);	//Queues a move that blends into the next queued move. Returns false if the queue is full
+		uint8_t queuedMoves();														//Returns the amount of queued moves
+		bool moveTo(float x, float z);												//Queues a move of the trolley and hoist to an absolute position in millimetres. Returns false if the queue is full
+		bool parseMoveCommand(const String& in);									//Parses a "MOVE:x,z" command (millimetres) and queues the move. Returns false if it is not one
+		int32_t positionOf(uint8_t stepper);										//Returns the position of stepper in steps
+		void setPositionOf(uint8_t stepper, int32_t steps);							//Overwrites the position of stepper (e.g. after homing). Only call this while it is not moving
+		void setStepsPerMm(uint8_t stepper, float stepsPerMm);						//Sets the calibration of stepper, in steps per millimetre
+		double setSpeedOf(uint8_t stepper, float rps); 								//sets the closest mode, and returns the deltaT (step period in milliseconds);
+		void setCentiSpeedOf(uint8_t stepper, int16_t centiRps);					//Sets the speed in hundredths of rotations per second (integer math only)
+		bool parseStepCommand(const String& in);									//Parses a "STEPn:x.xx" speed command and sets the speed. Returns false if it is not one
+		void stepSync();															//Queues the next chunk of constant speed movement on the step engine. Does not block
+		bool moveSteps(int32_t steps1, int32_t steps2, int32_t steps3, uint32_t duration);	//Queues a linear move on the step engine. Returns false if another move is already waiting
+		bool isMoving();															//True while the step engine is executing (or about to execute) a move
+		void stopSteppers();														//Stops the step engine immediately, and empties the look-ahead queue
+		void startTicker(uint32_t hz);												//Starts the periodic tick of the step engine (Timer2 on AVR)
+		void tick();																//Advances the step engine by one tick. Called from the timer interrupt
+		
+		//Public variables arduino 2
+		uint8_t stepperTest = 0;													//Bit n set: the step engine ran the self test moves of stepper n+1 in time (open loop: the motor is not checked). Also known to arduino 1
+		int runTime = 1;															//The runtime of the current stepper "event" in milliseconds (used in the stepSync function)
+		
+		
+		
+		//Public functions arduino 3
+		
+		//Public variables arduino 3
+		String statusString = "ERR";												//The current status of the crane. "ERR" = uninitialized
+		LiquidCrystal _lcd {8, 12, 4, 5, 6, 7};										//The LCD object
+		
+		
+		
+		//Shared Variables							
+		uint8_t  bufferIndex = 0;													//The amount of entries ever read from the buffer (wraps around). The next entry is in slot bufferIndex % CRANE_BUFFER_SLOTS
+		uint8_t  bufferLength = 0;													//The amount of entries ever added to the buffer (wraps around). The newest entry is bufferLength - 1
+		uint16_t bufferOverflows = 0;												//The amount of entries lost because the buffer was full
+		bool boardVerified;															//True if verify(), verify1(), verify2(), verify3() were all completed successfully
+		bool blueConnected = false;													//True if the bluetooth has been connected
+		int stateX;																	//The state of horizontal movement of the crane
+		int stateY;																	//The state of vertical movement of the crane
+		int law = 1;																//0: Direct law, 1: normal law, 2: precision law
+		uint8_t buttons = 0;														//Bit n set: button n of the controller is pressed
+		
+		
+		//Shared Functions							
+		Crane(uint8_t arduinoID);													//The constructor of this class
+		int verify();																//Verifies the components and the board
+		int init();																	//Initializes the components and the board
+		void instruct();															//Unused: Instructs an arduino to do something
+		void monitor();																//Unused: Monitors the situation
+		void update();																//Runs on the loop. For miscellaneous tasks
+		
+		void sendData(uint8_t arduino, byte data);									//Sends a byte of data to an arduino over I2C.
+		void sendData(uint8_t arduino, const String& data);							//Sends a string of data to an arduino over I2C.
+		void sendData(uint8_t arduino, const char* data);							//Sends a string literal to an arduino over I2C, without making a String.
+		void sendData(uint8_t arduino, const __FlashStringHelper* data);			//Sends a string stored in flash (F("...")) to an arduino over I2C.
+		void sendData(uint8_t arduino, const char* data, uint8_t length);			//Sends 'length' characters to an arduino over I2C.
+		void sendData(uint8_t arduino, const uint8_t* data, uint8_t length);		//Sends 'length' bytes from 'data' to an arduino over I2C.
+		void sendFrame(uint8_t arduino, uint8_t opcode, int32_t a = 0, int32_t b = 0);	//Sends a binary frame to an arduino over I2C. a, b: the payload fields of the opcode
+		
+		static uint8_t crc8(const uint8_t* data, uint8_t length);					//Returns the CRC-8 (polynomial 0x07) of 'length' bytes
+		static uint8_t framePayload(uint8_t opcode);								//Returns the payload length of an opcode, or 0xFF if the opcode is unknown
+		static uint8_t encodeFrame(uint8_t* frame, uint8_t opcode, uint8_t seq, int32_t a, int32_t b);	//Writes a frame (up to CRANE_FRAME_MAX bytes) and returns its length, or 0 if the opcode is unknown
+		static bool parseCommand(const uint8_t* text, uint8_t length, uint8_t& opcode, int32_t& a, int32_t& b);	//Translates a text command into the opcode and payload of the equivalent frame. Returns false if it is not a command
+		bool onCommand(uint8_t opcode, CraneCommand command);						//Registers the command of an application opcode. Returns false if the opcode is out of range
+		uint8_t queuedData(uint8_t arduino = 0);									//Returns the amount of messages waiting to be sent to an arduino (0: to any arduino)
+		void processTransmit();														//Sends the queued messages that are due, and retries the ones that were not acknowledged. Called by update()
+		uint16_t transmitFailures = 0;												//The amount of messages given up after CRANE_TX_ATTEMPTS
+		void sendSpeed(uint8_t stepper, int16_t centiRps);							//Sets the speed of a stepper on arduino 2. Sent by update(); a newer speed replaces a pending one
+		void flushSpeeds();															//Queues the pending speed commands for arduino 2 now, as one transaction
+		void sendCommand(uint8_t arduino, uint8_t opcode, const uint8_t* payload, uint8_t length);	//Sends an application frame to an arduino over I2C
+		static bool decodeFrame(const uint8_t* frame, uint8_t length, uint8_t& opcode, uint8_t& seq, int32_t& a, int32_t& b);	//Reads a frame. Returns false if it is malformed or the CRC does not match
+		void record(uint8_t type, uint8_t arg, int16_t value);						//Records a telemetry sample. Never waits: if the ring is full, the sample is dropped
+		void processTelemetry();													//Sends the recorded samples over Serial, one frame per telemetryInterval, only if it fits the Serial buffer. Called by update()
+		static uint8_t decodeTelemetry(const uint8_t* frame, uint8_t length, CraneSample* samples);	//Reads a telemetry frame into 'samples' (CRANE_TM_BATCH). Returns the amount of samples, 0 if it is malformed
+		uint16_t telemetryInterval = CRANE_TM_INTERVAL_MS;							//The time in between two telemetry frames, in milliseconds
+		uint16_t telemetryDropped = 0;												//The amount of telemetry samples dropped because the ring was full
+		
+		bool onReceive(int bytes);													//Queues a transmission received over I2C (call it from the Wire receive callback). Returns false if the queue was full
+		void processReceived();														//Handles the queued transmissions: applies commands and frames, adds other data to the buffer. Called by update()
+#if CRANE_BUS_STATS
+		CraneBusStats txStats = {};													//The statistics of the sent messages
+		CraneBusStats rxStats = {};													//The statistics of the received messages
+		uint32_t busStatsSince = 0;													//When the statistics were last reset (millis)
+#endif
+		void resetBusStats();														//Clears the bus statistics
+		void printBusStats();														//Prints the bus statistics to the serial monitor
+		volatile uint16_t receiveOverflows = 0;										//The amount of transmissions dropped because the receive queue was full
+		
+		void flushBuffer();															//Clears the buffer of all data
+		bool addToBuffer(const uint8_t* data, uint8_t length);						//Adds an element (text or a frame) to the buffer. Returns false if it does not fit
+		bool addToBuffer(const char* instruction);									//Adds an element to the buffer. Returns false if it does not fit
+		bool addToBuffer(const String& instruction);								//Adds an element to the buffer. Returns false if it does not fit
+		void pushBuffer(uint8_t arId, uint8_t n);									//Pushes the subscribed entries among the first n unread entries to an arduino over I2C (batched) and removes them from the buffer
+		void pushBuffer(uint8_t arId);												//Pushes all subscribed entries to an arduino over I2C (batched).
+		void removeNFromBuffer(uint8_t n);											//Removes n amount of elements from the buffer
+		int available();															//Returns the amount of unread elements in the buffer.
+		String readBuffer();														//Reads the first unread element, and removes it from the buffer.
+		uint8_t readBuffer(uint8_t* data, uint8_t size);							//Copies the first unread element into 'data', removes it from the buffer and returns its length (0: empty)
+};
+
+//-------------------------------- The crane has to leave room for the core, the libraries and the stack. If this fails, set CRANE_ROLE or make the queues smaller
+#if defined(__AVR_ATmega328P__)
+static_assert(sizeof(Crane) <= CRANE_RAM_BUDGET, "Crane does not fit the RAM of the ATmega328P: set CRANE_ROLE, or make the queues smaller");
+#endif
+
+
+
 #endif
\ No newline at end of file
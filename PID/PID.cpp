@@ -1,97 +1,199 @@
-/*
-***********************************************************************
-*					     ___ _____   _____ __  __ _____               *
-*					  / ____|  __ \ / ____|  \/  |  __ \              *
-*					 | |    | |  | | |  __| \  / | |  | |             *
-*					 | |    | |  | | | |_ | |\/| | |  | |             *
-*					 | |____| |__| | |__| | |  | | |__| |             *
-*					  \_____|_____/ \_____|_|  |_|_____/              *
-*					                                                  *
-***********************************************************************				                                     
-*
-*  Useful PID Library
-*
-*  Copyright © 2022 Rafael de Bie
-*  Permission is hereby granted, free of charge, to any person obtaining a
-*  copy of this software and associated documentation files (the "Software"),
-*  to deal in the Software without restriction, including without limitation
-*  the rights to use, copy, modify, merge, publish, distribute, sublicense,
-*  and/or sell copies of the Software, and to permit persons to whom the
-*  Software is furnished to do so, subject to the following conditions:
-*
-*  The above copyright notice and this permission notice shall be included in all copies or 
-*  substantial portions of the Software.
-*
-*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
-*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
-*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
-*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
-*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
-*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*
-*************************************************************************
-*
-* The API for this library:
-*
-* PID(float Kp, float Ki, float Kd): Constructor. Initializes Kp, Ki and Kd constants.
-*	-> Kp: the Kp constant
-*	-> Ki: the Ki constant
-*	-> Kd: the Kd constant
-*
-* setValues(float Kp, float Ki, float Kd): Redefines Kp, Ki, and Kd constants.
-*	-> Kp: the new Kp constant
-*	-> Ki: the new Ki constant
-*	-> Kd: the new Kd constant
-*
-* calculate(float target, float variable): calculates the PID output, given the target and variable.
-*	-> the target variable of the PID
-*	-> the variable to be processed
-*
-************************************************************************
-*/
-
-
-
-
-
-
-#include "Arduino.h"
-#include "PID.h"
-#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
- 
-using namespace std;
-
-
-/// The constructor of the PID class
-/// Sets Kp, Ki and Kd
-///
-PID::PID(float Kp, float Ki, float Kd)
-{
-	setValues(Kp,Ki,Kd);
-}
-
-/// sets new values for Kp, Ki and Kd
-/// 
-///
-void PID::setValues(float Kp, float Ki, float Kd)
-{
-	_Kp = Kp;
-	_Ki = Ki;
-	_Kd = Kd;
-}
-
-/// Calculates the value for the PID.
-/// Also updates Kd values
-///
-float PID::calculate(float target, float variable)
-{
-	float delta = target - variable;
-	float value = 0;
-	
-	value += delta * _Kp;
-	value += total * _Ki;
-	value += (delta - last) * _Kd;
-	total += delta;
-	last = delta;
-	return value;
+/*
+***********************************************************************
+*					     ___ _____   _____ __  __ _____               *
+*					  / ____|  __ \ / ____|  \/  |  __ \              *
+*					 | |    | |  | | |  __| \  / | |  | |             *
+*					 | |    | |  | | | |_ | |\/| | |  | |             *
+*					 | |____| |__| | |__| | |  | | |__| |             *
+*					  \_____|_____/ \_____|_|  |_|_____/              *
+*					                                                  *
+***********************************************************************				                                     
+*
+*  Useful PID Library
+*
+*  Copyright © 2022 Rafael de Bie
+*  Permission is hereby granted, free of charge, to any person obtaining a
+*  copy of this software and associated documentation files (the "Software"),
+*  to deal in the Software without restriction, including without limitation
+*  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+*  and/or sell copies of the Software, and to permit persons to whom the
+*  Software is furnished to do so, subject to the following conditions:
+*
+*  The above copyright notice and this permission notice shall be included in all copies or 
+*  substantial portions of the Software.
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*************************************************************************
+*
+* The API for this library:
+*
+* PID(float Kp, float Ki, float Kd): Constructor. Initializes Kp, Ki and Kd constants.
+*	-> Kp: the Kp constant
+*	-> Ki: the Ki constant
+*	-> Kd: the Kd constant
+*
+* setValues(float Kp, float Ki, float Kd): Redefines Kp, Ki, and Kd constants. Bumpless: the output does not jump when the constants change
+*	-> Kp: the new Kp constant
+*	-> Ki: the new Ki constant
+*	-> Kd: the new Kd constant
+*
+* calculate(float target, float variable): calculates the PID output, given the target and variable. Each call counts as one unit of time
+*	The integral term includes the error of this call (Ki * error is added before the output is calculated). It used to lag one call behind
+*	-> the target variable of the PID
+*	-> the variable to be processed
+*
+* calculate(float target, float variable, float dt): calculates the PID output, 'dt' seconds after the previous call. Ki and Kd are per second
+*	-> dt: the time since the previous call, in seconds (0: only the proportional term is updated)
+*
+* calculateAt(float target, float variable, unsigned long now): calculates the PID output at time 'now' (micros()). The first call after a reset has no dt
+*
+* setOutputLimits(float min, float max): Saturates the output to [min, max]. Also limits the integral term to the same range, unless setIntegralLimits is used
+*
+* setIntegralLimits(float min, float max): Clamps the integral term (in output units) to [min, max]
+*
+* setAntiWindup(float Kb): Sets the back-calculation gain (per second, default 1). While the output saturates, the integral is pulled back by Kb * (saturated - unsaturated output)
+*
+* setDerivativeFilter(float Tf): Sets the time constant (seconds) of the first-order filter on the derivative. 0: no filter (default)
+*
+* reset(): Clears the integral term and the derivative. The next call starts fresh
+*
+* The derivative acts on the measured variable, not on the error, so a change of the target does not kick the output
+*
+************************************************************************
+*/
+
+
+
+
+
+
+#include "Arduino.h"
+#include "PID.h"
+#include "C:\Program Files (x86)\Arduino\libraries\LiquidCrystal\src\LiquidCrystal.h"
+ 
+using namespace std;
+
+
+/// The constructor of the PID class
+/// Sets Kp, Ki and Kd
+///
+PID::PID(float Kp, float Ki, float Kd)
+{
+	setValues(Kp,Ki,Kd);
+}
+
+/// sets new values for Kp, Ki and Kd
+/// The integral term is corrected for the change of the proportional and derivative terms, so the output does not jump (bumpless)
+///
+void PID::setValues(float Kp, float Ki, float Kd)
+{
+	//-------------------------------- Once running, move the difference of the P and D terms into the integral term
+	if(started)
+	{
+		total += (_Kp - Kp) * lastError - (_Kd - Kd) * slope;
+		total = constrain(total, intMin, intMax);
+	}
+	
+	_Kp = Kp;
+	_Ki = Ki;
+	_Kd = Kd;
+}
+
+/// Calculates the value for the PID.
+/// Each call counts as one unit of time, as it always has
+///
+float PID::calculate(float target, float variable)
+{
+	return calculate(target, variable, 1);
+}
+
+/// Calculates the value for the PID, 'dt' seconds after the previous call
+/// The derivative is taken of the variable (filtered, see setDerivativeFilter), the integral is clamped and pulled back while the output saturates
+float PID::calculate(float target, float variable, float dt)
+{
+	float delta = target - variable;
+	
+	//-------------------------------- The derivative of the variable, through a first order filter. Nothing to compare to on the first call
+	if(started && dt > 0)
+	{
+		float rate = (variable - last) / dt;
+		slope += (rate - slope) * dt / (_Tf + dt);
+	}
+	
+	//-------------------------------- The integral term, in output units (so changing Ki does not make the output jump)
+	if(dt > 0) total = constrain(total + delta * _Ki * dt, intMin, intMax);
+	
+	//-------------------------------- The output, saturated. While it saturates, back-calculation pulls the integral back toward the limit
+	float value = delta * _Kp + total - slope * _Kd;
+	float limited = constrain(value, outMin, outMax);
+	if(dt > 0 && limited != value) total = constrain(total + (limited - value) * _Kb * dt, intMin, intMax);
+	
+	last = variable;
+	lastError = delta;
+	started = true;
+	return limited;
+}
+
+/// Calculates the value for the PID at time 'now' (micros)
+/// The time since the previous call is the dt. The first call after a reset only starts the clock
+///
+float PID::calculateAt(float target, float variable, unsigned long now)
+{
+	float dt = started ? (now - lastTime) * 1e-6 : 0;
+	lastTime = now;
+	return calculate(target, variable, dt);
+}
+
+/// Limits the output to [min, max]
+/// The integral term is limited to the same range, unless setIntegralLimits set its own
+///
+void PID::setOutputLimits(float min, float max)
+{
+	outMin = min;
+	outMax = max;
+	if(!intLimited) { intMin = min; intMax = max; total = constrain(total, intMin, intMax); }
+}
+
+/// Limits the integral term (in output units) to [min, max]
+/// 
+///
+void PID::setIntegralLimits(float min, float max)
+{
+	intMin = min;
+	intMax = max;
+	intLimited = true;
+	total = constrain(total, intMin, intMax);
+}
+
+/// Sets the back-calculation gain of the anti-windup, per second
+/// 0 turns back-calculation off, so only the integral limits apply
+///
+void PID::setAntiWindup(float Kb)
+{
+	_Kb = Kb;
+}
+
+/// Sets the time constant of the derivative filter, in seconds
+/// 0 turns the filter off
+///
+void PID::setDerivativeFilter(float Tf)
+{
+	_Tf = Tf;
+}
+
+/// Clears the integral term and the derivative
+/// The next call starts fresh, as if the PID was just made
+///
+void PID::reset()
+{
+	total = 0;
+	slope = 0;
+	lastError = 0;
+	started = false;
 }
\ No newline at end of file
@@ -1,28 +1,46 @@
-#ifndef PID_h
-#define PID_h
-
-
-#include <inttypes.h>
-#include "Arduino.h"
-
-class PID
-{
-	public:
-	
-	PID(float Kp, float Ki, float Kd);									//PID constructor
-	void setValues(float Kp, float Ki, float Kd);						//Updates the Kp, Ki, and Kd values of the PID
-	float calculate(float target, float variable);						//Calculates and updates the PID
-	
-	float _Kp = 0;														//The Kp Constant 
-	float _Ki = 0;														//The Ki Constant
-	float _Kd = 0;														//The Kd Constant
-	
-	private:
-	float last = 0;														//The last delta value (Used for Kd)
-	float total = 0;													//The total delta value (Used for Ki)
-	
-};
-
-
-
+#ifndef PID_h
+#define PID_h
+
+
+#include <inttypes.h>
+#include "Arduino.h"
+
+class PID
+{
+	public:
+	
+	PID(float Kp, float Ki, float Kd);									//PID constructor
+	void setValues(float Kp, float Ki, float Kd);						//Updates the Kp, Ki, and Kd values of the PID, without a jump in the output
+	float calculate(float target, float variable);						//Calculates and updates the PID (one unit of time per call)
+	float calculate(float target, float variable, float dt);			//Calculates and updates the PID, 'dt' seconds after the previous call
+	float calculateAt(float target, float variable, unsigned long now);	//Calculates and updates the PID at time 'now' (micros)
+	void setOutputLimits(float min, float max);							//Limits the output (and the integral, unless setIntegralLimits is used)
+	void setIntegralLimits(float min, float max);						//Limits the integral term
+	void setAntiWindup(float Kb);										//Sets the back-calculation gain (per second). 0: only clamp the integral
+	void setDerivativeFilter(float Tf);									//Sets the time constant of the derivative filter, in seconds. 0: no filter
+	void reset();														//Clears the integral and the derivative, the next call starts fresh
+	
+	float _Kp = 0;														//The Kp Constant 
+	float _Ki = 0;														//The Ki Constant
+	float _Kd = 0;														//The Kd Constant
+	
+	private:
+	float last = 0;														//The last measured variable (Used for Kd)
+	float total = 0;													//The integral term, in output units (Used for Ki)
+	float lastError = 0;												//The last error (Used for bumpless gain changes)
+	float slope = 0;													//The filtered rate of change of the variable, per second
+	bool started = false;												//True once calculate has run since the last reset
+	unsigned long lastTime = 0;											//The time of the last calculateAt (micros)
+	float outMin = -INFINITY;											//The lowest output
+	float outMax = INFINITY;											//The highest output
+	float intMin = -INFINITY;											//The lowest integral term
+	float intMax = INFINITY;											//The highest integral term
+	bool intLimited = false;											//True if the integral limits were set by setIntegralLimits
+	float _Kb = 1;														//The back-calculation gain, per second
+	float _Tf = 0;														//The time constant of the derivative filter, in seconds
+	
+};
+
+
+
 #endif
\ No newline at end of file
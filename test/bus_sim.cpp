@@ -0,0 +1,301 @@
+/// Three boards on one simulated I2C bus: arduino 1, 2 and 3 run in their own threads, in real time
+/// The bus takes the time the bits take at 100 or 400 kHz. A receiver with its interrupts off stretches the clock until they are back on,
+/// and its TWI interrupt stretches every byte. The receive callback runs before the bus is released, like the Wire interrupt holding SCL.
+///
+/// Arduino 1 sends data to arduino 2 and 3 (sendData) and pings arduino 2, which replies from update2 (pushBuffer). Arduino 3 sends data to arduino 1.
+/// Each speed runs twice: paced (a message every BUS_PACE_US per sender), for the latency, and flat out, for the throughput.
+/// Prints latency histograms of sendData (the call until the sketch read it), pushBuffer (the ping until its reply was delivered) and onReceive,
+/// and the statistics the library keeps itself (txStats, rxStats). Every data message has to arrive once and in order: a receiver with a full queue
+/// does not acknowledge its address, and the sender tries again
+
+#include "Crane.h"
+#include "Wire.h"
+#include "host.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#define BUS_RUN_MS 300												//How long each run sends, in milliseconds
+#define BUS_DRAIN_MS 30												//How long the boards keep running after that, so everything in flight arrives
+#define BUS_BYTE_STRETCH_US 4										//How long the TWI interrupt of the receiver holds SCL low after each byte (about 60 cycles at 16 MHz)
+#define BUS_PACE_US 2000												//The time between the messages of a sender in the paced runs
+#define BUS_PING_US 5000											//The time between the pings of arduino 1
+#define BUS_STAMPS 4096												//The amount of send times kept per sender (a power of two)
+#define BUS_BUCKETS 12												//Histogram bucket k: less than 16 << k microseconds (the last one: the rest)
+
+/// A latency histogram
+///
+struct Histogram
+{
+	uint32_t counts[BUS_BUCKETS];
+	uint32_t n;
+	uint64_t total;
+	uint32_t max;
+
+	void add(uint32_t us)
+	{
+		uint8_t k = 0;
+		while(k < BUS_BUCKETS - 1 && us >= (16UL << k)) k++;
+		counts[k]++;
+		n++;
+		total += us;
+		if(us > max) max = us;
+	}
+
+	/// The upper bound of the bucket that holds fraction 'p' of the samples
+	uint32_t percentile(double p) const
+	{
+		uint32_t seen = 0;
+		for(uint8_t k = 0; k < BUS_BUCKETS; k++) if((seen += counts[k]) >= p * n) return 16UL << k;
+		return max;
+	}
+
+	void print(const char* name) const
+	{
+		printf("  %-10s %6u msgs, mean %7.1f us, p50 < %5u us, p99 < %5u us, max %6u us |", name, n, n ? (double)total / n : 0.0, percentile(0.5), percentile(0.99), max);
+		for(uint8_t k = 0; k < BUS_BUCKETS; k++) printf(" %u", counts[k]);
+		printf("\n");
+	}
+};
+
+/// A data message between two boards: [BUS_DATA][sequence number, 4 bytes]. Never a command or a frame
+///
+#define BUS_DATA 'D'
+#define BUS_DATA_LEN 5
+
+/// A stream of data messages from one board to another
+///
+struct Stream
+{
+	uint8_t from, to;												//The arduino IDs
+	uint32_t sent;													//The amount of messages sent
+	uint32_t received;												//The amount of messages the receiver read
+	uint32_t next;													//The sequence number the receiver expects next
+	uint32_t outOfOrder;											//The amount of messages that arrived out of order (skipped numbers are counted once the receiver overflowed)
+	unsigned long stamps[BUS_STAMPS];								//When each message was sent (micros), by sequence number
+	Histogram latency;
+};
+
+//-------------------------------- The simulation
+static Crane* boards[3];
+static Stream streams[3] = { { 1, 2 }, { 1, 3 }, { 3, 1 } };
+static std::mutex bus;												//The bus: one transaction at a time
+static uint32_t bitTime;											//The time of one bit, in nanoseconds
+static uint64_t busBusy;											//The time the bus was busy, in nanoseconds
+static uint32_t stretches;											//The amount of transactions that were stretched because the receiver had its interrupts off
+static uint32_t refused;											//The amount of transactions that got a NACK because the receive queue of the receiver was full
+static Histogram receiveTimes, pingTimes;
+static unsigned long pingDelivered;									//When the last ping was delivered to arduino 2 (micros). 0: none pending
+static uint32_t pings, pingReplies;
+static std::atomic<bool> sending, running;
+
+/// Waits until 'ns' nanoseconds after 'start'
+///
+static void waitUntil(std::chrono::steady_clock::time_point start, uint64_t ns)
+{
+	while((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count() < ns) {}
+}
+
+/// A transaction on the bus, called from the thread of the sender (Wire.endTransmission)
+/// Returns the status of Wire.endTransmission: 0 acknowledged, 2 no such address (or the receiver does not acknowledge it)
+static uint8_t transmit(uint8_t address, const uint8_t* data, uint8_t length)
+{
+	std::lock_guard<std::mutex> hold(bus);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//-------------------------------- START and the address byte: nobody acknowledges an address that is not a board
+	uint64_t ns = 10ULL * bitTime;
+	waitUntil(start, ns);
+	if(address < 1 || address > 3) { busBusy += ns + bitTime; return 2; }
+	if(!hostAcknowledging(address)) { busBusy += ns + bitTime; refused++; return 2; }
+	uint8_t board = address - 1;
+
+	//-------------------------------- The TWI interrupt of the receiver has to run before the first byte: its interrupts being off stretches the clock
+	std::unique_lock<std::mutex> interrupts(hostInterrupts[board], std::try_to_lock);
+	if(!interrupts.owns_lock()) { stretches++; interrupts.lock(); }
+
+	//-------------------------------- The data bytes (8 bits and the acknowledge each, stretched by the interrupt), and STOP
+	ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	ns += length * (9ULL * bitTime + BUS_BYTE_STRETCH_US * 1000ULL) + bitTime;
+	waitUntil(start, ns);
+
+	//-------------------------------- The receive callback of the receiver. It reads the Wire of this thread
+	unsigned long before = micros();
+	memcpy(Wire._rx, data, length);
+	Wire._rxLength = length;
+	Wire._rxRead = 0;
+	boards[board]->onReceive(length);
+	unsigned long after = micros();
+	receiveTimes.add(after - before);
+
+	//-------------------------------- A ping to arduino 2, or its reply to arduino 1
+	uint8_t opcode, seq;
+	int32_t a, b;
+	if(Crane::decodeFrame(data, length, opcode, seq, a, b) && opcode == CRANE_OP_PING && address == 2) pingDelivered = after;
+	bool reply = Crane::decodeFrame(data, length, opcode, seq, a, b) && opcode == CRANE_OP_OK && a == 2;
+	if(length && data[0] == CRANE_OP_BATCH)
+		for(uint8_t i = 1; i < length && i + 1 + data[i] <= length; i += 1 + data[i])
+			if(Crane::decodeFrame(data + i + 1, data[i], opcode, seq, a, b) && opcode == CRANE_OP_OK && a == 2) reply = true;
+	if(reply && pingDelivered) { pingTimes.add(after - pingDelivered); pingDelivered = 0; pingReplies++; }
+
+	busBusy += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	return 0;
+}
+
+/// Sends the next data message of a stream
+///
+static void sendNext(Crane& crane, Stream& stream)
+{
+	uint8_t message[BUS_DATA_LEN] = { BUS_DATA };
+	memcpy(message + 1, &stream.sent, 4);
+	stream.stamps[stream.sent & (BUS_STAMPS - 1)] = micros();
+	crane.sendData(stream.to, message, BUS_DATA_LEN);
+	stream.sent++;
+}
+
+/// Reads the data the sketch of a board got
+///
+static void readData(Crane& crane, uint8_t arduino)
+{
+	uint8_t message[CRANE_SLOT_LEN];
+	uint8_t length;
+	while((length = crane.readBuffer(message, sizeof(message))))
+	{
+		if(length != BUS_DATA_LEN || message[0] != BUS_DATA) continue;
+		uint32_t seq;
+		memcpy(&seq, message + 1, 4);
+
+		//-------------------------------- Find the stream: arduino 1 only gets data from arduino 3
+		Stream& stream = arduino == 1 ? streams[2] : streams[arduino - 2];
+		stream.latency.add(micros() - stream.stamps[seq & (BUS_STAMPS - 1)]);
+		if(seq != stream.next) stream.outOfOrder++;
+		stream.next = seq + 1;
+		stream.received++;
+	}
+}
+
+/// The sketch of one board: update() as fast as it goes, sending as the run asks
+///
+static void runBoard(uint8_t board, bool paced)
+{
+	hostBoard = board;
+	Crane& crane = *boards[board];
+	uint8_t arduino = board + 1;
+	unsigned long lastSend = micros(), lastPing = micros();
+
+	while(running)
+	{
+		crane.update();
+		readData(crane, arduino);
+
+		//-------------------------------- Paced: every BUS_PACE_US. Flat out: as soon as the previous message to the same board has left
+		unsigned long now = micros();
+		bool due = !paced || now - lastSend >= BUS_PACE_US;
+		if(sending && due)
+		{
+			lastSend = now;
+			for(uint8_t s = 0; s < 3; s++)
+				if(streams[s].from == arduino && (paced || !crane.queuedData(streams[s].to))) sendNext(crane, streams[s]);
+		}
+		if(sending && arduino == 1 && now - lastPing >= BUS_PING_US)
+		{
+			lastPing = now;
+			crane.sendFrame(2, CRANE_OP_PING);
+			pings++;
+		}
+
+		//-------------------------------- Leave the processor to the other boards (the host may have fewer cores than there are boards)
+		std::this_thread::yield();
+	}
+}
+
+/// Runs the three boards at bus speed 'hz' for BUS_RUN_MS, and prints what happened. Returns the data messages delivered per second
+///
+static double run(uint32_t hz, bool paced)
+{
+	//-------------------------------- Fresh boards and statistics
+	hostReset();
+	hostRealTime = true;
+	hostOnTransmit = transmit;
+	bitTime = 1000000000UL / hz;
+	busBusy = 0;
+	stretches = 0;
+	refused = 0;
+	pingDelivered = 0;
+	pings = pingReplies = 0;
+	memset(&receiveTimes, 0, sizeof(receiveTimes));
+	memset(&pingTimes, 0, sizeof(pingTimes));
+	for(uint8_t s = 0; s < 3; s++)
+	{
+		uint8_t from = streams[s].from, to = streams[s].to;
+		memset(&streams[s], 0, sizeof(Stream));
+		streams[s].from = from;
+		streams[s].to = to;
+	}
+	for(uint8_t b = 0; b < 3; b++) boards[b] = &hostCrane(b + 1, b);
+
+	//-------------------------------- Send for BUS_RUN_MS, then let everything in flight arrive
+	sending = true;
+	running = true;
+	unsigned long start = micros();
+	std::thread threads[3];
+	for(uint8_t b = 0; b < 3; b++) threads[b] = std::thread(runBoard, b, paced);
+	std::this_thread::sleep_for(std::chrono::milliseconds(BUS_RUN_MS));
+	sending = false;
+	unsigned long sent = micros() - start;
+	std::this_thread::sleep_for(std::chrono::milliseconds(BUS_DRAIN_MS));
+	running = false;
+	for(uint8_t b = 0; b < 3; b++) threads[b].join();
+
+	//-------------------------------- Report
+	uint32_t delivered = 0, bytes = 0;
+	printf("%u kHz, %s: bus busy %.0f%% (%u stretched by interrupts being off, %u refused by a full receive queue)\n", hz / 1000, paced ? "paced" : "flat out", 100.0 * busBusy / (sent * 1000.0), stretches, refused);
+	for(uint8_t s = 0; s < 3; s++)
+	{
+		Stream& stream = streams[s];
+		Crane& receiver = *boards[stream.to - 1];
+		char name[32];
+		snprintf(name, sizeof(name), "sendData %d>%d", stream.from, stream.to);
+		stream.latency.print(name);
+		delivered += stream.received;
+
+		//-------------------------------- Every message arrived, once and in order: a full receive queue only delays them
+		CHECK(stream.received == stream.sent && !stream.outOfOrder, "%u kHz: %d>%d: %u of %u messages arrived, %u out of order", hz / 1000, stream.from, stream.to, stream.received, stream.sent, stream.outOfOrder);
+		CHECK(!receiver.receiveOverflows, "%u kHz: arduino %d dropped %u acknowledged transmissions", hz / 1000, stream.to, receiver.receiveOverflows);
+	}
+	pingTimes.print("pushBuffer");
+	receiveTimes.print("onReceive");
+	for(uint8_t b = 0; b < 3; b++)
+	{
+		Crane& crane = *boards[b];
+		bytes += crane.rxStats.bytes;
+		printf("  arduino %d: sent %u (%u bytes, mean %.0f us), received %u (%u bytes, %.0f us to update), %u overflows, %u failures\n", b + 1,
+			crane.txStats.messages, crane.txStats.bytes, crane.txStats.messages ? (double)crane.txStats.micros / crane.txStats.messages : 0.0,
+			crane.rxStats.messages, crane.rxStats.bytes, crane.rxStats.messages ? (double)crane.rxStats.micros / crane.rxStats.messages : 0.0,
+			crane.receiveOverflows, crane.transmitFailures);
+		CHECK(!crane.transmitFailures, "%u kHz: arduino %d gave up on %u messages", hz / 1000, b + 1, crane.transmitFailures);
+	}
+	//-------------------------------- Arduino 3 only sends data messages: its transactions cannot be shorter than the bits they take (a refused one: START, address and NACK)
+	const CraneBusStats& stats = boards[2]->txStats;
+	double bits = (10 + 9 * BUS_DATA_LEN + 1) * bitTime / 1000.0 + BUS_DATA_LEN * BUS_BYTE_STRETCH_US;
+	double least = (stats.messages - stats.failures) * bits + stats.failures * 11 * bitTime / 1000.0;
+	CHECK(stats.micros >= least - stats.messages, "%u kHz: %u data messages took %u us on the bus, their bits take %.0f us", hz / 1000, stats.messages, stats.micros, least);
+	
+	double perSecond = delivered * 1000000.0 / sent;
+	printf("  throughput: %.0f data messages/s, %.0f bytes/s on the bus; %u pings, %u replies\n", perSecond, bytes * 1000000.0 / sent, pings, pingReplies);
+	CHECK(pingReplies > 0, "%u kHz: arduino 2 never replied to a ping", hz / 1000);
+
+	hostRealTime = false;
+	hostOnTransmit = 0;
+	return perSecond;
+}
+
+int main()
+{
+	run(100000, true);
+	double slow = run(100000, false);
+	run(400000, true);
+	double fast = run(400000, false);
+	CHECK(fast > slow, "400 kHz moved %.0f messages/s, 100 kHz %.0f", fast, slow);
+	return hostResult();
+}
@@ -0,0 +1,104 @@
+/// Coalescing of speed commands on arduino 2: transmissions of nothing but STEP frames go straight to the speed slots, the newest speed of a stepper wins
+/// Anything else (a batch with other messages in it, a lone 0xFF, an empty batch) has to go through the receive queue as usual
+
+#include "Crane.h"
+#include "host.h"
+
+/// A STEP frame: stepper, speed in 0.01 rotations per second
+///
+static uint8_t step(uint8_t* frame, uint8_t stepper, int16_t centi)
+{
+	return Crane::encodeFrame(frame, CRANE_OP_STEP, 0, stepper, centi);
+}
+
+/// Handles what was received, then runs the speeds for one second (stepSync every millisecond, 20 kHz ticks). Returns the steps of each stepper
+///
+static void runSecond(Crane& crane, long steps[3])
+{
+	crane.processReceived();
+	long start[3] = { hostSteps[0], hostSteps[1], hostSteps[2] };
+	for(uint32_t t = 0; t < 20000; t++)
+	{
+		if(t % 20 == 0) crane.stepSync();
+		hostMicros += 50;
+		crane.tick();
+	}
+	for(uint8_t a = 0; a < 3; a++) steps[a] = hostSteps[a] - start[a];
+}
+
+/// Several speeds for one stepper, each in its own transmission, before update() gets to them: only the last one is applied, none is queued
+///
+static void lastWins()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(20000);
+	
+	uint8_t frame[CRANE_FRAME_MAX];
+	bool taken = true;
+	for(int16_t centi = 100; centi <= 300; centi += 100) taken &= hostReceive(crane, frame, step(frame, 1, centi));
+	CHECK(taken && !crane.receiveOverflows, "the speed commands were not all taken (%d receive overflows)", crane.receiveOverflows);
+	
+	long steps[3];
+	runSecond(crane, steps);
+	printf("three speeds for stepper 1: %ld steps in a second\n", steps[0]);
+	CHECK(labs(steps[0] - 3 * CRANE_STEPS_PER_REV) <= 2, "stepper 1 took %ld steps, expected %d (3.00 rotations per second)", steps[0], 3 * CRANE_STEPS_PER_REV);
+	CHECK(!crane.available(), "a speed command ended up in the buffer");
+}
+
+/// A batch of speeds: each stepper gets its last speed
+///
+static void batch()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(20000);
+	
+	uint8_t data[CRANE_WIRE_BUFFER] = { CRANE_OP_BATCH };
+	uint8_t length = 1;
+	const int16_t speeds[3][2] = { { 1, 100 }, { 2, 200 }, { 1, -50 } };
+	for(uint8_t m = 0; m < 3; m++) { data[length] = step(data + length + 1, speeds[m][0], speeds[m][1]); length += 1 + data[length]; }
+	hostReceive(crane, data, length);
+	
+	long steps[3];
+	runSecond(crane, steps);
+	printf("batch: %ld and %ld steps\n", steps[0], steps[1]);
+	CHECK(labs(steps[0] + CRANE_STEPS_PER_REV / 2) <= 2, "stepper 1 took %ld steps, expected %d", steps[0], -CRANE_STEPS_PER_REV / 2);
+	CHECK(labs(steps[1] - 2 * CRANE_STEPS_PER_REV) <= 2, "stepper 2 took %ld steps, expected %d", steps[1], 2 * CRANE_STEPS_PER_REV);
+}
+
+/// Transmissions that are not only speed commands go to the queue: their data reaches the buffer, their speeds are still applied
+///
+static void fallThrough()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(20000);
+	uint8_t read[CRANE_SLOT_LEN];
+	
+	//-------------------------------- A batch of a speed and some text
+	uint8_t data[CRANE_WIRE_BUFFER] = { CRANE_OP_BATCH };
+	data[1] = step(data + 2, 1, 100);
+	uint8_t length = 2 + data[1];
+	data[length++] = 1;
+	data[length++] = 'x';
+	hostReceive(crane, data, length);
+	long steps[3];
+	runSecond(crane, steps);
+	CHECK(crane.readBuffer(read, sizeof(read)) == 1 && read[0] == 'x', "the text of a mixed batch did not reach the buffer");
+	CHECK(labs(steps[0] - CRANE_STEPS_PER_REV) <= 2, "the speed of a mixed batch was not applied (%ld steps)", steps[0]);
+	
+	//-------------------------------- A lone 0xFF is data, not an empty batch of speeds
+	const uint8_t marker = CRANE_OP_BATCH;
+	hostReceive(crane, &marker, 1);
+	crane.processReceived();
+	CHECK(crane.readBuffer(read, sizeof(read)) == 1 && read[0] == CRANE_OP_BATCH, "a lone 0xFF did not reach the buffer");
+}
+
+int main()
+{
+	lastWins();
+	batch();
+	fallThrough();
+	return hostResult();
+}
@@ -0,0 +1,77 @@
+/// The range sensor of arduino 1: updateEcho triggers it, echoTick times the echo on the ticks of Timer2
+/// Replays echoes tick by tick, with the ticks that the SoftwareSerial receive interrupt holds back (the interrupts are off for about 1 ms
+/// per byte at 9600 baud). An echo has to be timed to within a tick, and an echo with an edge seen by a late tick has to be thrown away
+/// (echoLate), not taken as a distance up to 170 mm off. A late tick without an edge changes nothing
+
+#include "Crane.h"
+#include "host.h"
+
+#define ECHO_TICK_US (1000000UL / CRANE_ECHO_TICK_HZ)
+#define ECHO_BYTE_US 1040											//The interrupts are off for one byte of SoftwareSerial at 9600 baud
+#define ECHO_WIDTH_US 5800											//The echo of ECHO_MM
+#define ECHO_MM 1000
+#define ECHO_WITHIN_MM 9											//A tick of 50 us is about 8.6 mm
+
+#define ECHO_TIMED(mm) ((mm) >= ECHO_MM - ECHO_WITHIN_MM && (mm) <= ECHO_MM + ECHO_WITHIN_MM)
+
+/// One measurement: the echo comes 'rise' us after the trigger, and lasts 'width' us. No tick runs from 'gap' us after the trigger for
+/// 'gapLength' us (0: none): the last tick that was due in between runs when the gap ends, the ones before it are lost
+/// Returns the distance that came in (0: none)
+///
+static uint16_t measure(Crane& crane, uint32_t rise, uint32_t gap = 0, uint32_t gapLength = 0, uint32_t width = ECHO_WIDTH_US)
+{
+	//-------------------------------- Trigger, then tick until the echo is done (the interrupt stops itself)
+	hostMicros += CRANE_ECHO_CYCLE_MS * 1000UL;
+	crane.update();
+	unsigned long trigger = hostMicros;
+	for(unsigned long t = 0; t < 2 * CRANE_ECHO_MAX_US; t += ECHO_TICK_US)
+	{
+		unsigned long now = t;
+		if(t > gap && t < gap + gapLength)
+		{
+			if(t + ECHO_TICK_US < gap + gapLength) continue;
+			now = gap + gapLength;
+		}
+		hostMicros = trigger + now;
+		hostPin[6] = now >= rise && now < rise + width;
+		crane.echoTick();
+	}
+
+	//-------------------------------- Collect it before the next trigger is due: a distance came in if it was measured at this trigger
+	hostMicros = trigger + (CRANE_ECHO_CYCLE_MS - 1) * 1000UL;
+	crane.update();
+	unsigned long time = 0;
+	uint16_t distance = crane.latestDistance(&time);
+	return time == trigger / 1000 ? distance : 0;
+}
+
+int main()
+{
+	hostReset();
+	hostMicros = 1000000;
+	Crane& crane = hostCrane(1);
+
+	//-------------------------------- Timed to within a tick, on every phase of the tick
+	for(uint32_t phase = 0; phase < ECHO_TICK_US; phase += 10)
+	{
+		uint16_t distance = measure(crane, 500 + phase);
+		CHECK(ECHO_TIMED(distance), "the echo 500+%u us after the trigger read %u mm, not %u", phase, distance, ECHO_MM);
+	}
+
+	//-------------------------------- A byte of the HC-06 while the echo is high, and one before it: the echo is still timed
+	uint16_t inside = measure(crane, 500, 2000, ECHO_BYTE_US);
+	uint16_t before = measure(crane, 2000, 500, ECHO_BYTE_US);
+	CHECK(ECHO_TIMED(inside) && ECHO_TIMED(before), "with a late tick away from the edges, the echo read %u and %u mm", inside, before);
+	CHECK(crane.echoLate == 0 && crane.echoMisses == 0, "%u echoes thrown away as late, %u missed", crane.echoLate, crane.echoMisses);
+
+	//-------------------------------- A byte over the rising edge, or over the falling edge: the echo is thrown away
+	uint16_t rising = measure(crane, 1000, 500, ECHO_BYTE_US);
+	uint16_t falling = measure(crane, 500, 6000, ECHO_BYTE_US);
+	printf("late edges: rising %u mm, falling %u mm (0: thrown away), %u late\n", rising, falling, crane.echoLate);
+	CHECK(!rising && !falling && crane.echoLate == 2, "an echo with a late edge read %u and %u mm, %u thrown away", rising, falling, crane.echoLate);
+
+	//-------------------------------- The next echo is timed again
+	uint16_t next = measure(crane, 500);
+	CHECK(ECHO_TIMED(next) && crane.echoMisses == 0, "after the late echoes, the echo read %u mm, %u missed", next, crane.echoMisses);
+	return hostResult();
+}
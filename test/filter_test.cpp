@@ -0,0 +1,138 @@
+/// Replays traces of the range sensor (arduino 1) through Crane::filterSample, one sample every CRANE_ECHO_CYCLE_MS
+/// The hook stands, rises at 200 mm/s, stands, and lowers at 300 mm/s. On top of that: sensor noise, spikes (an echo off the rope, or one
+/// that came back late) and dropped samples. The median has to keep the spikes out of the height, and the height and velocity have to
+/// follow the truth within bounds: tightly while the hook stands, with a bounded lag while it moves, and without losing track over a dropout
+
+#include "Crane.h"
+#include "host.h"
+
+#define FILTER_NOISE_MM 3											//The noise of the sensor: uniform in +-this, in millimetres
+#define FILTER_SETTLE_MS 1000										//After the hook starts or stops, or samples were lost, the filter gets this long before it is checked tightly
+#define FILTER_STILL_MM 8											//The worst height error while standing (settled), in millimetres
+#define FILTER_STILL_V 25											//The worst velocity error while standing (settled), in millimetres per second
+#define FILTER_RAMP_V 40											//The worst velocity error while moving (settled), in millimetres per second
+#define FILTER_LAG_MS 150											//The worst lag of the height while moving (settled), in milliseconds: the median alone is 2 samples
+#define FILTER_ANY_MM 100											//The worst height error anywhere, in millimetres: the starts and stops, and the samples right after a dropout, included
+#define FILTER_FASTEST 300											//The fastest the hook moves, in millimetres per second
+
+//-------------------------------- Two spikes on the same side push the median back by two samples while the hook moves. That adds to the bounds:
+//-------------------------------- their time to the lag, the distance the hook moves in it to the height, and the velocity the filter takes from that jump
+#define FILTER_PUSHED_LAG_MS (2 * CRANE_ECHO_CYCLE_MS)
+#define FILTER_PUSHED_MM (FILTER_FASTEST * FILTER_PUSHED_LAG_MS / 1000)
+#define FILTER_PUSHED_V (2 * FILTER_FASTEST * CRANE_FILTER_BETA / 256)
+
+/// The true height at 'ms', and its velocity
+///
+static double truth(uint32_t ms, double* velocity)
+{
+	//-------------------------------- Stand at 1000, rise to 1400 (2-4 s), stand, lower to 800 (6-8 s), stand
+	double t = ms / 1000.0;
+	*velocity = t >= 2 && t < 4 ? 200 : t >= 6 && t < 8 ? -300 : 0;
+	if(t < 2) return 1000;
+	if(t < 4) return 1000 + 200 * (t - 2);
+	if(t < 6) return 1400;
+	if(t < 8) return 1400 - 300 * (t - 6);
+	return 800;
+}
+
+/// The time since the hook last started or stopped, in milliseconds
+///
+static uint32_t sinceChange(uint32_t ms)
+{
+	uint32_t changes[] = { 0, 2000, 4000, 6000, 8000 };
+	uint32_t last = 0;
+	for(uint8_t i = 0; i < 5; i++) if(ms >= changes[i]) last = changes[i];
+	return ms - last;
+}
+
+/// What went in and what came out of one trace
+///
+struct Replay
+{
+	uint32_t spikes, dropped;										//The amount of spikes fed, and of samples dropped
+	double stillHeight, stillVelocity;								//The worst errors while standing
+	double rampVelocity, rampLag;									//The worst velocity error and lag while moving
+	double anyHeight;												//The worst height error anywhere
+	double spikeHeight;												//The worst height error on a sample that was a spike, while standing (settled)
+};
+
+/// Replays 10 seconds of samples. spike(n) returns the reading of sample n if it is a spike (0: it is not), dropped(n) whether sample n is lost
+///
+static Replay replay(const char* name, uint16_t (*spike)(uint32_t), bool (*dropped)(uint32_t))
+{
+	CraneFilter filter = {};
+	Replay r = {};
+	uint32_t seed = 12345;
+	uint32_t lastDrop = 0;
+	for(uint32_t n = 0; n * CRANE_ECHO_CYCLE_MS < 10000; n++)
+	{
+		uint32_t ms = n * CRANE_ECHO_CYCLE_MS;
+		double v, height = truth(ms, &v);
+		seed = seed * 1103515245 + 12345;
+		int noise = (int)((seed >> 16) % (2 * FILTER_NOISE_MM + 1)) - FILTER_NOISE_MM;
+		if(dropped(n)) { r.dropped++; lastDrop = ms; continue; }
+		uint16_t reading = spike(n);
+		if(reading) r.spikes++;
+		else reading = (uint16_t)lround(height) + noise;
+		Crane::filterSample(filter, reading, ms);
+		if(n < CRANE_MEDIAN_LEN) continue;
+
+		//-------------------------------- The errors of this sample
+		double heightError = fabs(filter.height / 256.0 - height);
+		double velocityError = fabs(filter.velocity / 256.0 - v);
+		bool settled = sinceChange(ms) >= FILTER_SETTLE_MS && (!r.dropped || ms - lastDrop >= FILTER_SETTLE_MS);
+		if(heightError > r.anyHeight) r.anyHeight = heightError;
+		if(settled && !v)
+		{
+			if(spike(n) && heightError > r.spikeHeight) r.spikeHeight = heightError;
+			if(heightError > r.stillHeight) r.stillHeight = heightError;
+			if(velocityError > r.stillVelocity) r.stillVelocity = velocityError;
+		}
+		if(settled && v)
+		{
+			if(velocityError > r.rampVelocity) r.rampVelocity = velocityError;
+			double lag = 1000 * heightError / fabs(v);
+			if(lag > r.rampLag) r.rampLag = lag;
+		}
+	}
+	printf("%-9s %3u spikes, %3u dropped: standing %4.1f mm %5.1f mm/s (on a spike %3.1f mm), moving %5.1f mm/s %4.0f ms lag, anywhere %5.1f mm\n", name,
+		r.spikes, r.dropped, r.stillHeight, r.stillVelocity, r.spikeHeight, r.rampVelocity, r.rampLag, r.anyHeight);
+
+	//-------------------------------- A spike while standing is rejected outright: the median of the other samples is the height
+	bool pushed = r.spikes > 0;
+	CHECK(r.stillHeight <= FILTER_STILL_MM && r.stillVelocity <= FILTER_STILL_V, "%s: standing, the filter was %.1f mm and %.1f mm/s off", name, r.stillHeight, r.stillVelocity);
+	CHECK(r.spikeHeight <= FILTER_STILL_MM, "%s: standing, a spike moved the height %.1f mm", name, r.spikeHeight);
+	CHECK(r.rampVelocity <= FILTER_RAMP_V + pushed * FILTER_PUSHED_V && r.rampLag <= FILTER_LAG_MS + pushed * FILTER_PUSHED_LAG_MS, "%s: moving, the filter was %.1f mm/s off, and %.0f ms behind", name, r.rampVelocity, r.rampLag);
+	CHECK(r.anyHeight <= FILTER_ANY_MM + pushed * FILTER_PUSHED_MM, "%s: the height was %.1f mm off", name, r.anyHeight);
+	return r;
+}
+
+static uint16_t noSpikes(uint32_t) { return 0; }
+static bool noneDropped(uint32_t) { return false; }
+
+//-------------------------------- Spikes: one in ten samples reads 4 m (an echo that came back late), and two in a row out of thirty read 40 mm (the rope). At most 2 in a window of 5
+static uint16_t spikes(uint32_t n) { return n % 10 == 3 ? 4000 : n % 30 == 17 || n % 30 == 18 ? 40 : 0; }
+
+//-------------------------------- Dropouts: three samples lost on each ramp, and a gap of 840 ms while standing (longer than CRANE_FILTER_RESET_MS: the filter starts over)
+static bool dropouts(uint32_t n) { return (n >= 50 && n < 53) || (n >= 120 && n < 123) || (n >= 150 && n < 164); }
+
+int main()
+{
+	replay("clean", noSpikes, noneDropped);
+	replay("spikes", spikes, noneDropped);
+	replay("dropouts", noSpikes, dropouts);
+	replay("both", spikes, dropouts);
+
+	//-------------------------------- A single sample: a 4 m spike in a window of standing samples does not move the height at all
+	CraneFilter filter = {};
+	for(uint8_t n = 0; n < CRANE_MEDIAN_LEN; n++) Crane::filterSample(filter, 1000, n * CRANE_ECHO_CYCLE_MS);
+	Crane::filterSample(filter, 4000, CRANE_MEDIAN_LEN * CRANE_ECHO_CYCLE_MS);
+	CHECK(filter.height == 1000L << 8 && filter.velocity == 0, "a spike moved the height to %.2f mm, the velocity to %.2f mm/s", filter.height / 256.0, filter.velocity / 256.0);
+
+	//-------------------------------- After the long dropout, the filter starts over from the next sample: standing still
+	filter = CraneFilter();
+	for(uint8_t n = 0; n < CRANE_MEDIAN_LEN; n++) Crane::filterSample(filter, 1000 + 12 * n, n * CRANE_ECHO_CYCLE_MS);
+	Crane::filterSample(filter, 1100, CRANE_MEDIAN_LEN * CRANE_ECHO_CYCLE_MS + CRANE_FILTER_RESET_MS + 1);
+	CHECK(filter.velocity == 0, "after a dropout, the filter kept a velocity of %.2f mm/s", filter.velocity / 256.0);
+	return hostResult();
+}
@@ -0,0 +1,139 @@
+/// Binary frames against the text commands they replaced: bytes per message, and encode/decode throughput
+/// The text side is built the way sendData was called (String concatenation) and read back with parseCommand.
+/// Both sides have to agree on every message, and the frames have to be shorter in total ("OK2" is a byte shorter as text)
+
+#include "Crane.h"
+#include "host.h"
+#include <chrono>
+
+#define BENCH_ROUNDS 200000UL										//The amount of times the message set is encoded and decoded
+
+/// A message of the benchmark: its frame fields
+///
+struct BenchMessage
+{
+	uint8_t opcode;
+	int32_t a;
+	int32_t b;
+};
+
+static const BenchMessage messages[] =
+{
+	{ CRANE_OP_PING, 0, 0 },
+	{ CRANE_OP_OK, 2, 0 },
+	{ CRANE_OP_VERIFY_OK, 0, 0 },
+	{ CRANE_OP_CONNECTED, 0, 0 },
+	{ CRANE_OP_BLUE, 3, 0 },
+	{ CRANE_OP_STEP, 1, -1234 },
+	{ CRANE_OP_STEP, 3, 50 },
+	{ CRANE_OP_MOVE, 12345, -6789 },
+	{ CRANE_OP_SELF, 5, 0 },
+};
+#define BENCH_MESSAGES (sizeof(messages) / sizeof(messages[0]))
+
+/// Writes a number in units of 0.01 as text, with two decimals
+///
+static String centi(int32_t value)
+{
+	String text = value < 0 ? "-" : "";
+	uint32_t magnitude = value < 0 ? -value : value;
+	String decimals = String((int)(magnitude % 100));
+	return text + String((int)(magnitude / 100)) + "." + (magnitude % 100 < 10 ? "0" : "") + decimals;
+}
+
+/// The text command of a message, as it used to be passed to sendData
+///
+static String textOf(const BenchMessage& m)
+{
+	switch(m.opcode)
+	{
+		case CRANE_OP_PING: return "Ping";
+		case CRANE_OP_OK: return "OK" + String((int)m.a);
+		case CRANE_OP_VERIFY_OK: return "VerifyOK";
+		case CRANE_OP_CONNECTED: return "CONNECTED";
+		case CRANE_OP_BLUE: return m.a == 1 ? "blueOK" : m.a == 2 ? "blueERR" : "blueINOP";
+		case CRANE_OP_STEP: return "STEP" + String((int)m.a) + ":" + centi(m.b);
+		case CRANE_OP_MOVE: return "MOVE:" + centi(m.a) + "," + centi(m.b);
+		case CRANE_OP_SELF:
+		{
+			String text = "SELF2:";
+			for(uint8_t s = 0; s < 3; s++) text += (m.a >> s) & 1 ? 'P' : 'F';
+			return text;
+		}
+	}
+	return "";
+}
+
+/// Nanoseconds since 'start'
+///
+static double since(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+	uint8_t frames[BENCH_MESSAGES][CRANE_FRAME_MAX];
+	uint8_t frameLengths[BENCH_MESSAGES];
+	String texts[BENCH_MESSAGES];
+	unsigned textBytes = 0, frameBytes = 0;
+	
+	//-------------------------------- Bytes per message, and both sides read back the same fields
+	for(uint8_t i = 0; i < BENCH_MESSAGES; i++)
+	{
+		const BenchMessage& m = messages[i];
+		frameLengths[i] = Crane::encodeFrame(frames[i], m.opcode, i, m.a, m.b);
+		texts[i] = textOf(m);
+		textBytes += texts[i].length();
+		frameBytes += frameLengths[i];
+		
+		uint8_t opcode, seq;
+		int32_t a, b;
+		bool frameOk = Crane::decodeFrame(frames[i], frameLengths[i], opcode, seq, a, b);
+		CHECK(frameOk && opcode == m.opcode && a == m.a && b == m.b, "the frame of message %d does not read back", i);
+		bool textOk = Crane::parseCommand((const uint8_t*)texts[i].c_str(), texts[i].length(), opcode, a, b);
+		CHECK(textOk && opcode == m.opcode && a == m.a && b == m.b, "\"%s\" does not read back", texts[i].c_str());
+		printf("%-20s %2d bytes, frame %2d bytes\n", texts[i].c_str(), texts[i].length(), frameLengths[i]);
+	}
+	printf("per message: text %.1f bytes, frame %.1f bytes\n", (double)textBytes / BENCH_MESSAGES, (double)frameBytes / BENCH_MESSAGES);
+	CHECK(frameBytes < textBytes, "the frames take %d bytes, the text %d", frameBytes, textBytes);
+	
+	//-------------------------------- Throughput. The sums keep the compiler from dropping the work
+	uint32_t sum = 0;
+	uint8_t frame[CRANE_FRAME_MAX];
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(unsigned long r = 0; r < BENCH_ROUNDS; r++)
+		for(uint8_t i = 0; i < BENCH_MESSAGES; i++) sum += Crane::encodeFrame(frame, messages[i].opcode, r, messages[i].a, messages[i].b) + frame[1];
+	double frameEncode = since(start);
+	
+	start = std::chrono::steady_clock::now();
+	for(unsigned long r = 0; r < BENCH_ROUNDS; r++)
+		for(uint8_t i = 0; i < BENCH_MESSAGES; i++) sum += textOf(messages[i]).length();
+	double textEncode = since(start);
+	
+	start = std::chrono::steady_clock::now();
+	for(unsigned long r = 0; r < BENCH_ROUNDS; r++)
+		for(uint8_t i = 0; i < BENCH_MESSAGES; i++)
+		{
+			uint8_t opcode, seq;
+			int32_t a = 0, b = 0;
+			sum += Crane::decodeFrame(frames[i], frameLengths[i], opcode, seq, a, b) + a + b;
+		}
+	double frameDecode = since(start);
+	
+	start = std::chrono::steady_clock::now();
+	for(unsigned long r = 0; r < BENCH_ROUNDS; r++)
+		for(uint8_t i = 0; i < BENCH_MESSAGES; i++)
+		{
+			uint8_t opcode;
+			int32_t a = 0, b = 0;
+			sum += Crane::parseCommand((const uint8_t*)texts[i].c_str(), texts[i].length(), opcode, a, b) + a + b;
+		}
+	double textDecode = since(start);
+	
+	double count = (double)BENCH_ROUNDS * BENCH_MESSAGES;
+	printf("encode: text %.1f ns, frame %.1f ns per message\n", textEncode / count, frameEncode / count);
+	printf("decode: text %.1f ns, frame %.1f ns per message (the frame decode includes its CRC)\n", textDecode / count, frameDecode / count);
+	printf("(checksum %u)\n", (unsigned)sum);
+	return hostResult();
+}
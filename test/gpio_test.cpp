@@ -0,0 +1,101 @@
+/// The pin writes of the step engine (arduino 2): pulseSteps and setDirections, the pins they set and the cycles they cost
+/// Built twice: gpio_test writes the pins with digitalWrite, gpio_test_fast with the port registers (CRANE_FAST_GPIO, as on the ATmega328P).
+/// Both have to step and turn exactly the steppers they are asked to, and leave the other pins and the interrupts as they were.
+/// The fast build is handed the cycles per pulse of the other (see the Makefile): a pulse has to cost the same for one stepper or three, and less than with digitalWrite
+
+#include "Crane.h"
+#include "host.h"
+
+/// The cycles of one pulse of the steppers in 'mask'
+///
+static unsigned long pulseCycles(Crane& crane, uint8_t mask)
+{
+	unsigned long before = hostCycles;
+	crane.pulseSteps(mask);
+	return hostCycles - before;
+}
+
+/// Every mask in every direction: exactly the steppers in the mask step, each the way its DIR bit says
+///
+static void pins()
+{
+	hostReset();
+	hostBoard = 0;
+	Crane& crane = hostCrane(2);
+
+	//-------------------------------- Pins 4 and 7 share PORTD with the steppers, pins 10 and 11 PORTB: they have to keep their levels
+	hostPin[4] = hostPin[7] = hostPin[10] = 1;
+	for(uint8_t dir = 0; dir < 8; dir++) for(uint8_t mask = 1; mask < 8; mask++)
+	{
+		long before[3] = { hostSteps[0], hostSteps[1], hostSteps[2] };
+		crane.setDirections(7, dir);
+		crane.pulseSteps(mask);
+		for(uint8_t a = 0; a < 3; a++)
+		{
+			long expected = !((mask >> a) & 1) ? 0 : ((dir >> a) & 1) ? 1 : -1;
+			CHECK(hostSteps[a] - before[a] == expected, "mask %d, dir %d: stepper %d moved %ld, not %ld", mask, dir, a + 1, hostSteps[a] - before[a], expected);
+		}
+		CHECK(!hostPin[2] && !hostPin[5] && !hostPin[8], "mask %d: a STEP pin was left high", mask);
+	}
+	CHECK(hostPin[4] && hostPin[7] && hostPin[10] && !hostPin[11], "the pins next to the steppers changed: %d %d %d %d", hostPin[4], hostPin[7], hostPin[10], hostPin[11]);
+
+	//-------------------------------- setDirections leaves the steppers outside its mask alone
+	crane.setDirections(7, 0);
+	crane.setDirections(2, 0xFF);
+	CHECK(!hostPin[3] && hostPin[6] && !hostPin[9], "setDirections(2, 0xFF) set the DIR pins to %d %d %d", hostPin[3], hostPin[6], hostPin[9]);
+	crane.setDirections(5, 0xFF);
+	CHECK(hostPin[3] && hostPin[6] && hostPin[9], "setDirections(5, 0xFF) set the DIR pins to %d %d %d", hostPin[3], hostPin[6], hostPin[9]);
+
+	//-------------------------------- The interrupts end up as they were: on stays on, off stays off
+	crane.pulseSteps(7);
+	CHECK(SREG & 0x80, "the interrupts were left off after a pulse");
+	noInterrupts();
+	crane.pulseSteps(7);
+	crane.setDirections(7, 0);
+	CHECK(!(SREG & 0x80), "a pulse turned the interrupts back on");
+	interrupts();
+	hostBoard = -1;
+}
+
+/// A move through the step engine: it pulses and turns the steppers with the same functions
+///
+static void move()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(20000);
+	crane.moveSteps(200, -120, 35, 100000UL);
+	unsigned long start = hostMicros, cycles = hostCycles;
+	for(long ticks = 1; crane.isMoving() && ticks < 4000; ticks++)
+	{
+		hostMicros = start + ticks * 50;
+		crane.tick();
+	}
+	printf("move: steps %ld %ld %ld, %lu cycles on the pins\n", hostSteps[0], hostSteps[1], hostSteps[2], hostCycles - cycles);
+	CHECK(hostSteps[0] == 200 && hostSteps[1] == -120 && hostSteps[2] == 35, "the move took %ld %ld %ld steps, not 200 -120 35", hostSteps[0], hostSteps[1], hostSteps[2]);
+}
+
+int main(int argc, char** argv)
+{
+	//-------------------------------- The cycles of a pulse of 1, 2 and 3 steppers
+	hostReset();
+	Crane& crane = hostCrane(2);
+	unsigned long cycles[3] = { pulseCycles(crane, 1), pulseCycles(crane, 3), pulseCycles(crane, 7) };
+	if(argc == 2 && !strcmp(argv[1], "--cycles")) { printf("%lu %lu %lu\n", cycles[0], cycles[1], cycles[2]); return 0; }
+
+#if defined(CRANE_FAST_GPIO)
+	printf("port registers: %lu, %lu, %lu cycles per pulse of 1, 2, 3 steppers\n", cycles[0], cycles[1], cycles[2]);
+	CHECK(cycles[0] == cycles[1] && cycles[1] == cycles[2], "a pulse costs more for more steppers");
+	for(uint8_t n = 0; n < 3 && argc == 4; n++)
+		CHECK(cycles[n] < strtoul(argv[n + 1], 0, 10), "a pulse of %d stepper(s) took %lu cycles, %s with digitalWrite", n + 1, cycles[n], argv[n + 1]);
+	if(argc == 4) printf("digitalWrite:   %s, %s, %s\n", argv[1], argv[2], argv[3]);
+#else
+	printf("digitalWrite: %lu, %lu, %lu cycles per pulse of 1, 2, 3 steppers\n", cycles[0], cycles[1], cycles[2]);
+	for(uint8_t n = 0; n < 3; n++)
+		CHECK(cycles[n] == 2UL * (n + 1) * HOST_DIGITALWRITE_CYCLES, "a pulse of %d stepper(s) took %lu cycles, not 2 digitalWrites per stepper", n + 1, cycles[n]);
+#endif
+
+	pins();
+	move();
+	return hostResult();
+}
@@ -0,0 +1,182 @@
+/// The HC-06 message parser: text lines and binary frames in one stream, and finding the frames again after bytes were lost
+/// A broken frame (wrong CRC, or cut off by silence) must not take the frames that started inside it down with it
+/// Then the joystick frames on top of it: a controller stream from encodeJoystick, through the parser, into joystickFrame
+
+#include "Crane.h"
+#include "host.h"
+#include <string>
+#include <vector>
+
+static std::vector<std::string> messages;					//The messages handed to the handlers: "L:" text lines, "F:" frames (their payload)
+
+static void onLine(Crane&, const uint8_t* data, uint8_t length) { messages.push_back("L:" + std::string((const char*)data, length)); }
+static void onFrame(Crane&, const uint8_t* data, uint8_t length) { messages.push_back("F:" + std::string((const char*)data, length)); }
+
+/// A frame: [CRANE_BT_SYNC][length][payload][CRC-8]
+///
+static std::string frame(const std::string& payload)
+{
+	std::string bytes = std::string(1, (char)CRANE_BT_SYNC) + (char)(payload.size() + 1) + payload;
+	return bytes + (char)Crane::crc8((const uint8_t*)payload.data(), payload.size());
+}
+
+/// What onFrame records for a frame
+///
+static std::string framed(const std::string& payload)
+{
+	return "F:" + payload + (char)Crane::crc8((const uint8_t*)payload.data(), payload.size());
+}
+
+/// Has the HC-06 receive 'bytes', then go quiet
+///
+static void receive(Crane& crane, const std::string& bytes)
+{
+	crane.hcSerial.receive((const uint8_t*)bytes.data(), bytes.size());
+	crane.pollHC06();
+	hostMicros += (CRANE_BT_GAP_MS + 1) * 1000UL;
+	crane.pollHC06();
+}
+
+/// Runs one stream through a new parser, and checks the messages that came out
+///
+static void expect(const char* name, const std::string& bytes, const std::vector<std::string>& expected, uint16_t broken)
+{
+	hostReset();
+	Crane& crane = hostCrane(1);
+	crane.onBlueLine(onLine);
+	crane.onBlueFrame(onFrame);
+	messages.clear();
+	receive(crane, bytes);
+	
+	printf("%s: %d messages, %d broken\n", name, (int)messages.size(), crane.blueOverflows);
+	CHECK(messages == expected, "%s: got %d messages, expected %d", name, (int)messages.size(), (int)expected.size());
+	CHECK(crane.blueOverflows == broken, "%s: %d broken messages, expected %d", name, crane.blueOverflows, broken);
+}
+
+/// A crane that applies the joystick frames it gets from the HC-06
+///
+static Crane& joystickCrane()
+{
+	hostReset();
+	Crane& crane = hostCrane(1);
+	crane.onBlueFrame(Crane::joystickFrame);
+	return crane;
+}
+
+/// Encodes the controller state, has the HC-06 receive the frame, and returns the frame
+///
+static std::string joystick(Crane& crane, CraneJoystick& sent, int8_t x, int8_t y, uint8_t law, uint8_t buttons)
+{
+	uint8_t bytes[CRANE_JOY_FRAME_MAX];
+	std::string frame((const char*)bytes, Crane::encodeJoystick(bytes, sent, x, y, law, buttons));
+	receive(crane, frame);
+	return frame;
+}
+
+/// Every state the frame holds: the bits land where the format says, the axes come back with their sign, and out of range axes are clamped
+///
+static void joystickStates()
+{
+	Crane& crane = joystickCrane();
+	CraneJoystick sent = {};
+	const uint8_t buttons[] = { 0x00, 0x01, 0xA5, 0xFF };
+	uint16_t states = 0;
+	for(int8_t x = -4; x <= 3; x++) for(int8_t y = -4; y <= 3; y++) for(uint8_t law = 0; law < 4; law++) for(uint8_t b = 0; b < 4; b++)
+	{
+		std::string frame = joystick(crane, sent, x, y, law, buttons[b]);
+		uint8_t packed = (x & 7) | ((y & 7) << 3) | (law << 6);
+		CHECK(frame.size() == 6 && (uint8_t)frame[2] == (CRANE_JOY_STATE | sent.seq) && (uint8_t)frame[3] == packed && (uint8_t)frame[4] == buttons[b], "x %d, y %d, law %d: the frame is packed wrong", x, y, law);
+		CHECK(crane.stateX == x && crane.stateY == y && crane.law == law && crane.buttons == buttons[b], "x %d, y %d, law %d, buttons %02X came back as %d, %d, %d, %02X", x, y, law, buttons[b], crane.stateX, crane.stateY, crane.law, crane.buttons);
+		states++;
+	}
+	joystick(crane, sent, 9, -9, 6, 0);
+	CHECK(crane.stateX == 3 && crane.stateY == -4 && crane.law == 2, "x 9, y -9, law 6 came back as %d, %d, %d", crane.stateX, crane.stateY, crane.law);
+	printf("joystick: %d states, %d rejected\n", states, crane.joystickErrors);
+	CHECK(!crane.joystickErrors, "%d joystick frames rejected", crane.joystickErrors);
+}
+
+/// A state that does not change: hold frames, and the state again every CRANE_JOY_REFRESH of them. Every one of them is taken
+/// The sequence number counts 1 to 63 and wraps to 1 (0 means nothing was sent)
+///
+static void joystickHolds()
+{
+	Crane& crane = joystickCrane();
+	CraneJoystick sent = {};
+	joystick(crane, sent, 2, -3, 1, 4);
+	uint8_t seq = sent.seq;
+	for(uint8_t refresh = 0; refresh < 3; refresh++)
+	{
+		for(uint8_t h = 0; h < CRANE_JOY_REFRESH; h++)
+		{
+			unsigned long before = crane.joystickTime;
+			std::string frame = joystick(crane, sent, 2, -3, 1, 4);
+			CHECK(frame.size() == 4 && (uint8_t)frame[2] == (CRANE_JOY_HOLD | seq), "hold %d: a %d byte frame, kind and seq %02X", h, (int)frame.size(), (uint8_t)frame[2]);
+			CHECK(crane.joystickTime > before, "hold %d was not taken", h);
+		}
+		std::string frame = joystick(crane, sent, 2, -3, 1, 4);
+		CHECK(frame.size() == 6 && (uint8_t)frame[2] == (CRANE_JOY_STATE | seq), "after %d holds, a %d byte frame, kind and seq %02X, not the state again", CRANE_JOY_REFRESH, (int)frame.size(), (uint8_t)frame[2]);
+	}
+	CHECK(!crane.joystickErrors && crane.stateX == 2 && crane.stateY == -3, "%d frames rejected, the state is %d, %d", crane.joystickErrors, crane.stateX, crane.stateY);
+
+	//-------------------------------- 150 changes: the sequence numbers go 1 to 63 and around, every state is taken
+	bool wrapped = true;
+	for(uint8_t i = 0; i < 150; i++)
+	{
+		uint8_t last = sent.seq;
+		joystick(crane, sent, i % 8 - 4, 0, 0, i);
+		if(sent.seq != last % 63 + 1) wrapped = false;
+		CHECK(crane.buttons == i, "change %d (seq %d) was not taken", i, sent.seq);
+	}
+	CHECK(wrapped && !crane.joystickErrors, "the sequence numbers did not go 1 to 63 and around (%d frames rejected)", crane.joystickErrors);
+}
+
+/// A state frame is lost: the hold frames after it confirm a state the receiver never got, so they are rejected, until the refresh brings it
+///
+static void joystickLost()
+{
+	Crane& crane = joystickCrane();
+	CraneJoystick sent = {};
+	joystick(crane, sent, 1, 1, 1, 1);
+
+	//-------------------------------- The next state never arrives
+	uint8_t lost[CRANE_JOY_FRAME_MAX];
+	Crane::encodeJoystick(lost, sent, -2, 3, 2, 8);
+	for(uint8_t h = 0; h < CRANE_JOY_REFRESH; h++) joystick(crane, sent, -2, 3, 2, 8);
+	CHECK(crane.joystickErrors == CRANE_JOY_REFRESH && crane.stateX == 1 && crane.buttons == 1, "after the lost state: %d of %d holds rejected, the state is %d, %d", crane.joystickErrors, CRANE_JOY_REFRESH, crane.stateX, crane.buttons);
+
+	//-------------------------------- The refresh brings the state, and its holds are taken again
+	joystick(crane, sent, -2, 3, 2, 8);
+	joystick(crane, sent, -2, 3, 2, 8);
+	CHECK(crane.joystickErrors == CRANE_JOY_REFRESH && crane.stateX == -2 && crane.stateY == 3 && crane.law == 2 && crane.buttons == 8, "after the refresh: %d rejected, the state is %d, %d, %d, %d", crane.joystickErrors, crane.stateX, crane.stateY, crane.law, crane.buttons);
+}
+
+int main()
+{
+	std::string a = frame("abc"), c = frame("z");
+	
+	//-------------------------------- Text and frames, one after the other. A frame right after text without its '\n' ends the text
+	expect("mixed", "hello\r\n" + a + "world" + c, { "L:hello", framed("abc"), "L:world", framed("z") }, 0);
+	
+	//-------------------------------- The end of a frame was lost: its length takes in the start of the next frame, which has to be found again
+	expect("cut off", std::string(1, (char)CRANE_BT_SYNC) + "\x04" + "q" + a + c, { framed("abc"), framed("z") }, 1);
+	
+	//-------------------------------- A frame with a long length: a whole frame, and the start of another, are inside it
+	expect("swallowed", std::string(1, (char)CRANE_BT_SYNC) + "\x0A" + "q" + a + c, { framed("abc"), framed("z") }, 1);
+	
+	//-------------------------------- A corrupted frame without a sync byte in it is dropped, the next one is not
+	std::string bad = a;
+	bad[3] ^= 1;
+	expect("corrupted", bad + c, { framed("z") }, 1);
+	
+	//-------------------------------- Half a frame, then silence: the frame inside it is still found
+	expect("silence", std::string(1, (char)CRANE_BT_SYNC) + "\x0C" + "q" + a, { framed("abc") }, 1);
+	
+	//-------------------------------- A length that cannot be right, followed by a sync byte: that one starts the frame
+	expect("bad length", std::string(1, (char)CRANE_BT_SYNC) + a, { framed("abc") }, 1);
+	
+	joystickStates();
+	joystickHolds();
+	joystickLost();
+	
+	return hostResult();
+}
@@ -0,0 +1,158 @@
+#include "host.h"
+#include "Wire.h"
+#include <new>
+#include <chrono>
+#include <atomic>
+
+HardwareSerial Serial;
+thread_local TwoWire Wire;
+
+unsigned long hostMicros = 0;
+thread_local uint8_t hostPin[64];
+thread_local long hostSteps[3];
+thread_local unsigned long hostCycles;
+HostPort PORTD = { 0 }, PORTB = { 8 }, PIND = { 0 }, PINB = { 8 };
+HostStatus SREG;
+bool hostRealTime = false;
+thread_local int8_t hostBoard = -1;
+std::mutex hostInterrupts[3];
+static thread_local bool interruptsOff = false;				//True while this thread holds the interrupts of its board
+static std::atomic<bool> acknowledging[4] = { { true }, { true }, { true }, { true } };	//The TWEA bit of each I2C address (1-3)
+HostStepHook hostOnStep = 0;
+HostTransmitHook hostOnTransmit = 0;
+int hostFailures = 0;
+
+void hostReset()
+{
+	hostMicros = 0;
+	memset(hostPin, 0, sizeof(hostPin));
+	memset(hostSteps, 0, sizeof(hostSteps));
+	hostCycles = 0;
+	hostOnStep = 0;
+	hostOnTransmit = 0;
+	Serial.written = 0;
+	Serial.room = 63;
+	for(uint8_t a = 0; a < 4; a++) acknowledging[a] = true;
+}
+
+Crane& hostCrane(uint8_t arduinoID, uint8_t board)
+{
+	//-------------------------------- The constructor leaves most members to the zero-initialization of globals, so the memory is cleared first
+	alignas(Crane) static uint8_t memory[3][sizeof(Crane)];
+	static Crane* cranes[3];
+	if(cranes[board]) cranes[board]->~Crane();
+	memset(memory[board], 0, sizeof(Crane));
+	cranes[board] = new(memory[board]) Crane(arduinoID);
+	hostAcknowledge(arduinoID, true);
+	return *cranes[board];
+}
+
+bool hostReceive(Crane& crane, const uint8_t* data, uint8_t length)
+{
+	if(length > sizeof(Wire._rx)) length = sizeof(Wire._rx);
+	memcpy(Wire._rx, data, length);
+	Wire._rxLength = length;
+	Wire._rxRead = 0;
+	return crane.onReceive(length);
+}
+
+void hostAcknowledge(uint8_t address, bool on) { if(address < 4) acknowledging[address] = on; }
+bool hostAcknowledging(uint8_t address) { return address >= 4 || acknowledging[address]; }
+
+uint8_t TwoWire::endTransmission()
+{
+	return hostOnTransmit ? hostOnTransmit(_address, _tx, _length) : 0;
+}
+
+int hostResult()
+{
+	printf(hostFailures ? "%d check(s) failed\n" : "ok\n", hostFailures);
+	return hostFailures ? 1 : 0;
+}
+
+/// The real clock, in microseconds since the first call
+///
+static unsigned long realMicros()
+{
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+unsigned long millis() { return micros() / 1000; }
+unsigned long micros() { return hostRealTime ? realMicros() : hostMicros; }
+void delay(unsigned long ms) { delayMicroseconds(ms * 1000); }
+
+void delayMicroseconds(unsigned int us)
+{
+	if(!hostRealTime) { hostMicros += us; return; }
+	unsigned long start = realMicros();
+	while(realMicros() - start < us) {}
+}
+
+//-------------------------------- Like cli() and sei(): they do not nest, interrupts() turns the interrupts back on whatever happened before
+void noInterrupts()
+{
+	if(hostBoard < 0 || interruptsOff) return;
+	hostInterrupts[hostBoard].lock();
+	interruptsOff = true;
+}
+
+void interrupts()
+{
+	if(hostBoard < 0 || !interruptsOff) return;
+	interruptsOff = false;
+	hostInterrupts[hostBoard].unlock();
+}
+unsigned long pulseIn(uint8_t, uint8_t, unsigned long) { return 0; }
+void pinMode(uint8_t, uint8_t) {}
+void analogWrite(uint8_t, int) {}
+int digitalRead(uint8_t pin) { return hostPin[pin & 63]; }
+
+/// Sets a pin. A rising edge on a STEP pin (2, 5, 8) is a step, in the direction of the DIR pin next to it
+///
+static void setPin(uint8_t pin, uint8_t value)
+{
+	if((pin == 2 || pin == 5 || pin == 8) && value && !hostPin[pin])
+	{
+		uint8_t axis = (pin - 2) / 3;
+		bool forward = hostPin[pin + 1];
+		hostSteps[axis] += forward ? 1 : -1;
+		if(hostOnStep) hostOnStep(axis, forward);
+	}
+	hostPin[pin] = value ? 1 : 0;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	hostCycles += HOST_DIGITALWRITE_CYCLES;
+	setPin(pin & 63, value);
+}
+
+HostPort::operator uint8_t() const
+{
+	hostCycles++;
+	uint8_t value = 0;
+	for(uint8_t bit = 0; bit < 8; bit++) value |= hostPin[first + bit] << bit;
+	return value;
+}
+
+HostPort& HostPort::operator=(uint8_t value)
+{
+	hostCycles++;
+	for(uint8_t bit = 0; bit < 8; bit++) if(hostPin[first + bit] != ((value >> bit) & 1)) setPin(first + bit, (value >> bit) & 1);
+	return *this;
+}
+
+HostStatus::operator uint8_t() const
+{
+	hostCycles++;
+	return interruptsOff ? 0 : 0x80;
+}
+
+HostStatus& HostStatus::operator=(uint8_t value)
+{
+	hostCycles++;
+	if(value & 0x80) interrupts();
+	else noInterrupts();
+	return *this;
+}
@@ -0,0 +1,35 @@
+#ifndef CraneHost_h
+#define CraneHost_h
+
+//-------------------------------- The simulated board behind the stubs in stub/: a clock that only moves when a test moves it, and the pins
+//-------------------------------- The STEP pins of the stepper drivers (2, 5, 8) are watched, so a test sees every step the library takes
+//-------------------------------- Tests with threads run one board per thread: the pins and Wire belong to the thread, and hostRealTime makes the clock real
+
+#include "Arduino.h"
+#include "Crane.h"
+#include <stdio.h>
+#include <mutex>
+
+typedef void (*HostStepHook)(uint8_t axis, bool forward);	//Called on every rising edge of a STEP pin (axis 0, 1, 2), with the level of its DIR pin
+typedef uint8_t (*HostTransmitHook)(uint8_t address, const uint8_t* data, uint8_t length);	//Called for every I2C transaction, returns the status of Wire.endTransmission (0: acknowledged)
+
+extern unsigned long hostMicros;							//The clock, in microseconds. delay() and delayMicroseconds() move it, millis() and micros() read it
+extern thread_local uint8_t hostPin[64];					//The level of each pin (of the board of this thread)
+extern thread_local long hostSteps[3];						//The position of each stepper, counted on its STEP and DIR pins
+extern bool hostRealTime;									//True: millis() and micros() follow the real clock, and delays wait. For tests with threads (see bus_sim)
+extern thread_local int8_t hostBoard;						//The board this thread runs (0-2). -1: none, noInterrupts() does nothing
+extern std::mutex hostInterrupts[3];						//Held while the interrupts of a board are off: noInterrupts() on its thread, or an interrupt running on another thread
+extern HostStepHook hostOnStep;								//Called on every step (0: none)
+extern HostTransmitHook hostOnTransmit;						//Called for every I2C transaction (0: every transaction is acknowledged and thrown away)
+
+void hostReset();											//Sets the clock, the pins and the step counts back to 0, and Serial back to throwing its output away
+Crane& hostCrane(uint8_t arduinoID, uint8_t board = 0);		//Makes a new crane on board 'board' (0-2) in zeroed memory, like a global on the Arduino, and returns it
+bool hostReceive(Crane& crane, const uint8_t* data, uint8_t length);	//Hands an I2C transmission to crane.onReceive, as the Wire receive interrupt does
+bool hostAcknowledging(uint8_t address);					//False while the board at 'address' refuses transmissions (its receive queue is full). hostReceive does not look
+
+//-------------------------------- Checks: print a line for each failure, and count them. main() returns hostResult()
+extern int hostFailures;
+#define CHECK(condition, ...) do { if(!(condition)) { hostFailures++; printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } } while(0)
+int hostResult();											//Prints the result, and returns the exit code of the test
+
+#endif
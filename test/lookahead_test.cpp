@@ -0,0 +1,131 @@
+/// The look-ahead queue of the step engine (arduino 2)
+/// Queued moves in the same direction have to blend: the step engine must not slow down at their junction.
+/// The speed at a junction is measured from the interval between the last step of one move and the first step of the next
+
+#include "Crane.h"
+#include "host.h"
+#include <vector>
+
+static std::vector<unsigned long> stepTimes;				//When each step of stepper 1 was taken (microseconds)
+
+static void onStep(uint8_t axis, bool forward)
+{
+	if(axis == 0) stepTimes.push_back(hostMicros);
+}
+
+/// Runs the crane for 'ms' milliseconds: 20 ticks and one update() per millisecond
+///
+static void run(Crane& crane, unsigned long ms)
+{
+	for(unsigned long t = 0; t < ms; t++)
+	{
+		for(uint8_t i = 0; i < 20; i++) { hostMicros += 50; crane.tick(); }
+		crane.update();
+	}
+}
+
+/// The speed of stepper 1 right after step 'n' (steps per second), from the interval to the next step
+///
+static float speedAfter(size_t n)
+{
+	return n < stepTimes.size() ? 1000000.0 / (stepTimes[n] - stepTimes[n - 1]) : 0;
+}
+
+/// Two collinear moves queued at once: the first must leave the junction at speed
+///
+static void queuedTogether()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	hostOnStep = onStep;
+	stepTimes.clear();
+	crane.startTicker(20000);
+	
+	crane.queueMove(2000, 0, 0, 0);
+	crane.queueMove(2000, 0, 0, 0);
+	run(crane, 6000);
+	
+	float junction = speedAfter(2000);
+	printf("queued together: %d steps, junction at %.0f steps/s\n", (int)stepTimes.size(), junction);
+	CHECK(stepTimes.size() == 4000, "took %d steps, expected 4000", (int)stepTimes.size());
+	CHECK(junction > 0.9 * CRANE_SPEED_1, "the junction is crossed at %.0f steps/s, expected about %d", junction, CRANE_SPEED_1);
+	CHECK(!crane.isMoving() && !crane.queuedMoves(), "the moves did not finish");
+}
+
+/// Moves queued one by one while the crane moves: each one is still in the queue when the next one comes in, so they blend
+/// (the first move started from standstill with nothing queued behind it, so it stops before the second one)
+static void streamed()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	hostOnStep = onStep;
+	stepTimes.clear();
+	crane.startTicker(20000);
+	
+	crane.queueMove(2000, 0, 0, 0);
+	run(crane, 500);
+	crane.queueMove(2000, 0, 0, 0);
+	run(crane, 1000);
+	crane.queueMove(2000, 0, 0, 0);
+	run(crane, 8000);
+	
+	float junction = speedAfter(4000);
+	printf("streamed: %d steps, second junction at %.0f steps/s\n", (int)stepTimes.size(), junction);
+	CHECK(stepTimes.size() == 6000, "took %d steps, expected 6000", (int)stepTimes.size());
+	CHECK(junction > 0.9 * CRANE_SPEED_1, "the second junction is crossed at %.0f steps/s, expected about %d", junction, CRANE_SPEED_1);
+}
+
+/// A reversal has to slow down to the junction jump
+///
+static void reversal()
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	hostOnStep = onStep;
+	stepTimes.clear();
+	crane.startTicker(20000);
+	
+	crane.queueMove(2000, 0, 0, 0);
+	crane.queueMove(-2000, 0, 0, 0);
+	run(crane, 8000);
+	
+	float junction = speedAfter(2000);
+	printf("reversal: %d steps, junction at %.0f steps/s, back at %ld\n", (int)stepTimes.size(), junction, hostSteps[0]);
+	CHECK(stepTimes.size() == 4000 && hostSteps[0] == 0, "took %d steps and ended at %ld, expected 4000 and 0", (int)stepTimes.size(), hostSteps[0]);
+	CHECK(junction <= CRANE_JUNCTION_JUMP, "the reversal is crossed at %.0f steps/s", junction);
+}
+
+/// A slow move (below 15.3 steps/s: an interval longer than the slowest ramp entry) blending into a fast one in the same direction
+/// The junction is planned at the slow speed: the slow move must not step faster than it, and the fast one has to ramp up from it
+///
+static void slowJunction(float slow)
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	hostOnStep = onStep;
+	stepTimes.clear();
+	crane.startTicker(20000);
+	
+	crane.queueMove(40, 0, 0, slow / CRANE_STEPS_PER_REV);
+	crane.queueMove(400, 0, 0, 0);
+	run(crane, 10000);
+	
+	float fastest = 0;
+	for(size_t n = 2; n < 40; n++) if(speedAfter(n) > fastest) fastest = speedAfter(n);
+	float junction = speedAfter(40), after = speedAfter(41);
+	printf("slow junction: %d steps at %.0f steps/s, then %.1f steps/s at the junction and %.1f right after\n", (int)stepTimes.size(), slow, junction, after);
+	CHECK(stepTimes.size() == 440 && !crane.isMoving(), "took %d steps, expected 440", (int)stepTimes.size());
+	CHECK(fastest < 1.1 * slow, "the slow move stepped at %.1f steps/s, it cruises at %.0f", fastest, slow);
+	CHECK(junction <= slow + CRANE_JUNCTION_JUMP && after <= slow + CRANE_JUNCTION_JUMP, "from %.0f steps/s, the junction is crossed at %.1f steps/s, then %.1f", slow, junction, after);
+}
+
+int main()
+{
+	queuedTogether();
+	streamed();
+	reversal();
+	slowJunction(5);
+	slowJunction(10);
+	slowJunction(14);
+	return hostResult();
+}
@@ -0,0 +1,63 @@
+/// How received messages are told apart: frames, batches, text commands and plain data
+/// Bytes sent with sendData(arduino, byte) can be 128 or more, like an opcode. They are data unless they make a valid frame (length and CRC-8)
+
+#include "Crane.h"
+#include "host.h"
+
+/// Hands 'data' to the crane as one transmission, and handles it
+///
+static void receive(Crane& crane, const uint8_t* data, uint8_t length)
+{
+	hostReceive(crane, data, length);
+	crane.processReceived();
+}
+
+/// Checks that the next entry of the buffer is 'data'
+///
+static void expectData(Crane& crane, const uint8_t* data, uint8_t length, const char* what)
+{
+	uint8_t read[CRANE_SLOT_LEN];
+	uint8_t got = crane.readBuffer(read, sizeof(read));
+	CHECK(got == length && !memcmp(read, data, length), "%s: read %d bytes into the buffer, expected %d", what, got, length);
+}
+
+int main()
+{
+	hostReset();
+	Crane& crane = hostCrane(3);
+	
+	//-------------------------------- Single bytes of 128 and up: data, including the opcodes and the batch marker
+	const uint8_t bytes[] = { 200, CRANE_OP_PING, CRANE_OP_STEP, CRANE_OP_USER, CRANE_OP_BATCH };
+	for(uint8_t i = 0; i < sizeof(bytes); i++)
+	{
+		receive(crane, bytes + i, 1);
+		expectData(crane, bytes + i, 1, "a single byte");
+	}
+	
+	//-------------------------------- Something that looks like a frame, but whose CRC does not match: data
+	uint8_t frame[CRANE_FRAME_MAX];
+	uint8_t length = Crane::encodeFrame(frame, CRANE_OP_VERIFY_OK, 0, 0, 0);
+	frame[length - 1] ^= 1;
+	receive(crane, frame, length);
+	expectData(crane, frame, length, "a frame with a bad CRC");
+	CHECK(!crane.boardVerified, "a frame with a bad CRC was applied");
+	
+	//-------------------------------- Data that starts with the batch marker, but does not split into messages: data
+	const uint8_t notBatch[] = { CRANE_OP_BATCH, 7, 'a' };
+	receive(crane, notBatch, sizeof(notBatch));
+	expectData(crane, notBatch, sizeof(notBatch), "a broken batch");
+	
+	//-------------------------------- A valid frame is applied, and is not data
+	frame[length - 1] ^= 1;
+	receive(crane, frame, length);
+	CHECK(crane.boardVerified, "a valid frame was not applied");
+	CHECK(!crane.available(), "a valid frame was added to the buffer");
+	
+	//-------------------------------- A batch of a byte and a text: both are data, in order
+	const uint8_t batch[] = { CRANE_OP_BATCH, 1, 250, 2, 'h', 'i' };
+	receive(crane, batch, sizeof(batch));
+	expectData(crane, batch + 2, 1, "the byte of a batch");
+	expectData(crane, batch + 4, 2, "the text of a batch");
+	
+	return hostResult();
+}
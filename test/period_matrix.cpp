@@ -0,0 +1,49 @@
+/// The test matrix of the synchronized speeds (arduino 2)
+/// Every triple of speeds runs through setSpeedOf and stepSync for three seconds at a 20 kHz tick, and the steps taken are compared with the requested ones.
+/// The periods are exact integers (Q24.8 microseconds) and the time left over is carried into the next chunk, so no speed may gain or lose more than a step
+
+#include "Crane.h"
+#include "host.h"
+
+int main()
+{
+	const float speeds[] = {0, 0.01f, 0.03f, 0.3f, 0.7f, 1, 1.3f, 2.2f, 3, 4.9f, 7.77f, 20};
+	const uint8_t count = sizeof(speeds) / sizeof(speeds[0]);
+	const unsigned long seconds = 3;
+	long worst = 0, triples = 0;
+	
+	for(uint8_t i = 0; i < count; i++)
+	for(uint8_t j = 0; j < count; j++)
+	for(uint8_t k = 0; k < count; k++)
+	{
+		hostReset();
+		Crane& crane = hostCrane(2);
+		crane.startTicker(20000);
+		
+		//-------------------------------- Stepper 2 runs backwards
+		const float rps[3] = {speeds[i], -speeds[j], speeds[k]};
+		for(uint8_t a = 0; a < 3; a++) crane.setSpeedOf(a + 1, rps[a]);
+		
+		//-------------------------------- stepSync once per millisecond (as from loop()), the tick at 20 kHz
+		for(unsigned long t = 0; t < seconds * 20000; t++)
+		{
+			if(t % 20 == 0) crane.stepSync();
+			hostMicros += 50;
+			crane.tick();
+		}
+		
+		//-------------------------------- The requested steps: 0.01 rotations per second is CRANE_STEPS_PER_REV / 100 steps per second
+		triples++;
+		for(uint8_t a = 0; a < 3; a++)
+		{
+			long centi = lround(rps[a] * 100);
+			long requested = centi * CRANE_STEPS_PER_REV / 100 * (long)seconds;
+			long error = labs(hostSteps[a] - requested);
+			if(error > worst) worst = error;
+			CHECK(error <= 1, "speeds %g %g %g: stepper %d took %ld steps, requested %ld", rps[0], rps[1], rps[2], a + 1, hostSteps[a], requested);
+		}
+	}
+	
+	printf("%ld speed triples, %lu s each: worst error %ld step(s)\n", triples, seconds, worst);
+	return hostResult();
+}
@@ -0,0 +1,143 @@
+/// Step responses of the PID library, on a first order plant (dy/dt = (u - y) / PID_TAU), sampled every PID_DT seconds
+/// Checks the anti-windup recovery, the output and integral limits, the derivative (on the measurement, filtered), bumpless gain changes,
+/// and the integral of calculate(target, variable): it includes the error of the current call (it used to lag one call behind)
+
+#include "PID/PID.h"
+#include "host.h"
+
+#define PID_TAU 0.5f												//The time constant of the plant, in seconds
+#define PID_DT 0.01f												//The time between two calculations, in seconds
+#define PID_STEPS 1000												//The length of a step response, in calculations
+
+/// The step response of a PID to a target of 1, with the plant input saturated to +-'limit' (0: not limited)
+///
+struct Response
+{
+	float end;														//The variable at the end
+	float overshoot;												//The highest the variable went above the target
+	float settle;													//The time after which the variable stays within 2% of the target, in seconds (-1: never)
+	float lowest, highest;											//The range of the output
+};
+
+static Response stepResponse(PID& pid, float limit)
+{
+	Response r = { 0, 0, -1, INFINITY, -INFINITY };
+	float y = 0;
+	for(int i = 0; i < PID_STEPS; i++)
+	{
+		float u = pid.calculate(1, y, PID_DT);
+		if(u < r.lowest) r.lowest = u;
+		if(u > r.highest) r.highest = u;
+		if(limit > 0) u = constrain(u, -limit, limit);
+		y += (u - y) / PID_TAU * PID_DT;
+		if(y - 1 > r.overshoot) r.overshoot = y - 1;
+		if(fabs(y - 1) > 0.02f) r.settle = -1; else if(r.settle < 0) r.settle = i * PID_DT;
+	}
+	r.end = y;
+	return r;
+}
+
+/// The one-argument-per-call form: one unit of time per call, and the integral includes the current error
+///
+static void unitTime()
+{
+	PID pid(1, 0.5, 0);
+	float first = pid.calculate(1, 0);
+	float second = pid.calculate(1, 0);
+	printf("calculate(target, variable): %.3f, %.3f\n", first, second);
+	CHECK(fabs(first - 1.5f) < 1e-6f, "the first output is %.4f, expected 1.5 (P 1 and Ki * e 0.5)", first);
+	CHECK(fabs(second - 2.0f) < 1e-6f, "the second output is %.4f, expected 2.0", second);
+	
+	//-------------------------------- With timestamps: the first call only starts the clock, the second integrates over 0.1 s
+	PID timed(1, 1, 0);
+	float start = timed.calculateAt(1, 0, 1000000UL);
+	float later = timed.calculateAt(1, 0, 1100000UL);
+	CHECK(fabs(start - 1) < 1e-6f && fabs(later - 1.1f) < 1e-5f, "calculateAt gave %.4f then %.4f, expected 1 then 1.1", start, later);
+}
+
+/// A saturated output: without anti-windup the integral winds up and the variable overshoots, clamping and back-calculation recover
+///
+static void antiWindup()
+{
+	PID free(2, 20, 0);
+	Response unlimited = stepResponse(free, 0);
+	
+	PID wound(2, 20, 0);
+	wound.setOutputLimits(-1.5, 1.5);
+	wound.setIntegralLimits(-1e9, 1e9);
+	wound.setAntiWindup(0);
+	Response windup = stepResponse(wound, 1.5);
+	
+	PID held(2, 20, 0);
+	held.setOutputLimits(-1.5, 1.5);
+	Response recovered = stepResponse(held, 1.5);
+	
+	printf("overshoot: unlimited %.3f, saturated %.3f, with anti-windup %.3f (settles at %.2f s, without: %.2f s)\n", unlimited.overshoot, windup.overshoot, recovered.overshoot, recovered.settle, windup.settle);
+	CHECK(fabs(unlimited.end - 1) < 0.01f && fabs(windup.end - 1) < 0.01f && fabs(recovered.end - 1) < 0.01f, "the responses end at %.3f, %.3f and %.3f, expected 1", unlimited.end, windup.end, recovered.end);
+	CHECK(windup.overshoot > unlimited.overshoot, "saturation without anti-windup overshot %.3f, unlimited %.3f", windup.overshoot, unlimited.overshoot);
+	CHECK(recovered.overshoot < windup.overshoot / 2, "anti-windup overshot %.3f, without it %.3f", recovered.overshoot, windup.overshoot);
+	CHECK(recovered.settle >= 0 && recovered.settle < windup.settle, "anti-windup settled at %.2f s, without it at %.2f s", recovered.settle, windup.settle);
+}
+
+/// The output never leaves its limits, and the integral term never leaves its own
+///
+static void limits()
+{
+	PID pid(2, 20, 0);
+	pid.setOutputLimits(-1.5, 1.5);
+	Response r = stepResponse(pid, 0);
+	CHECK(r.lowest >= -1.5f && r.highest <= 1.5f, "the output ranged %.3f to %.3f, limits -1.5 to 1.5", r.lowest, r.highest);
+	
+	//-------------------------------- Only an integral term, with a lasting error: it stops at its limit
+	PID integral(0, 1, 0);
+	integral.setIntegralLimits(-0.2, 0.2);
+	float u = 0;
+	for(int i = 0; i < 100; i++) u = integral.calculate(1, 0, 0.1);
+	CHECK(fabs(u - 0.2f) < 1e-6f, "the integral term went to %.4f, limit 0.2", u);
+	for(int i = 0; i < 3; i++) u = integral.calculate(-1, 0, 0.1);
+	CHECK(fabs(u - (-0.1f)) < 1e-5f, "the integral term is at %.4f after 0.3 s of the opposite error, expected -0.1 (it starts from the limit)", u);
+}
+
+/// The derivative acts on the measurement: a step of the target does not kick the output. A step of the measurement does, less so through the filter
+///
+static void derivative()
+{
+	PID pid(1, 0, 1);
+	pid.calculate(0, 0, PID_DT);
+	float kick = pid.calculate(5, 0, PID_DT);
+	CHECK(fabs(kick - 5) < 1e-5f, "a step of the target gave %.4f, expected 5 (no derivative kick)", kick);
+	
+	//-------------------------------- A step of 0.1 in the measurement: raw, the D term is -Kd * 0.1 / dt. The filter lets dt / (Tf + dt) of it through
+	float raw = pid.calculate(5, 0.1, PID_DT) - 4.9f;
+	PID filtered(1, 0, 1);
+	filtered.setDerivativeFilter(0.05);
+	filtered.calculate(5, 0, PID_DT);
+	float smooth = filtered.calculate(5, 0.1, PID_DT) - 4.9f;
+	printf("derivative of a 0.1 step: raw %.3f, filtered %.3f\n", raw, smooth);
+	CHECK(fabs(raw - (-10)) < 1e-3f, "the raw D term is %.4f, expected -10", raw);
+	CHECK(fabs(smooth - (-10 * PID_DT / (0.05f + PID_DT))) < 1e-3f, "the filtered D term is %.4f, expected %.4f", smooth, -10 * PID_DT / (0.05f + PID_DT));
+}
+
+/// Changing the gains while running does not make the output jump
+///
+static void bumpless()
+{
+	PID pid(2, 5, 0.5);
+	float y = 0;
+	for(int i = 0; i < 50; i++) { float u = pid.calculate(1, y, PID_DT); y += (u - y) / PID_TAU * PID_DT; }
+	float before = pid.calculate(1, y, 0);
+	pid.setValues(4, 1, 0.1);
+	float after = pid.calculate(1, y, 0);
+	printf("bumpless: %.4f -> %.4f\n", before, after);
+	CHECK(fabs(after - before) < 1e-4f, "the output jumped from %.4f to %.4f", before, after);
+}
+
+int main()
+{
+	unitTime();
+	antiWindup();
+	limits();
+	derivative();
+	bumpless();
+	return hostResult();
+}
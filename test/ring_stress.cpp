@@ -0,0 +1,116 @@
+/// The instruction buffer under sustained traffic: millions of random pushes and pops, checked against a model of the ring
+/// The buffer must keep its entries in order through every wraparound, apply its overflow policy when full, and never touch the heap.
+/// Built twice: ring_stress rejects new entries when full, ring_stress_drop is built with CRANE_BUFFER_DROP_OLDEST
+
+#include "Crane.h"
+#include "host.h"
+#include <new>
+
+#define STRESS_CYCLES 4000000UL										//The amount of pushes and pops
+
+//-------------------------------- Every heap allocation is counted while 'counting' is set
+static bool counting = false;
+static unsigned long allocations = 0;
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* p, size_t size);
+extern "C" void* malloc(size_t size) { if(counting) allocations++; return __libc_malloc(size); }
+extern "C" void* calloc(size_t count, size_t size) { if(counting) allocations++; return __libc_calloc(count, size); }
+extern "C" void* realloc(void* p, size_t size) { if(counting) allocations++; return __libc_realloc(p, size); }
+void* operator new(size_t size) { void* p = malloc(size); if(!p) throw std::bad_alloc(); return p; }
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+/// A small random number generator (xorshift), so the run is the same every time
+///
+static uint32_t next()
+{
+	static uint32_t state = 2463534242UL;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+/// Writes entry 'id': its id, then bytes counting up from it
+///
+static void fill(uint8_t* data, uint8_t length, uint32_t id)
+{
+	for(uint8_t i = 0; i < length; i++) data[i] = i < 4 ? id >> (8 * i) : id + i;
+}
+
+int main()
+{
+	hostReset();
+	Crane& crane = hostCrane(1);
+	
+	//-------------------------------- The model: the ids and lengths of the entries in the buffer, oldest first
+	uint32_t ids[CRANE_BUFFER_SLOTS];
+	uint8_t lengths[CRANE_BUFFER_SLOTS];
+	uint8_t head = 0, count = 0;
+	uint32_t nextId = 0;
+	unsigned long pushed = 0, popped = 0, rejected = 0, dropped = 0, wraps = 0, errors = 0;
+	uint8_t entry[CRANE_SLOT_LEN], read[CRANE_SLOT_LEN + 1];
+	
+	counting = true;
+	for(unsigned long c = 0; c < STRESS_CYCLES && errors < 10; c++)
+	{
+		uint32_t r = next();
+		
+		//-------------------------------- Push or pop, a bit more pushes in long runs so the buffer goes from empty to full and back
+		bool push = (c >> 12) & 1 ? r % 8 < 5 : r % 8 < 3;
+		if(push)
+		{
+			uint8_t length = 1 + (r >> 8) % CRANE_SLOT_LEN;
+			fill(entry, length, nextId);
+			bool added = crane.addToBuffer(entry, length);
+			
+			if(count == CRANE_BUFFER_SLOTS)
+			{
+#ifdef CRANE_BUFFER_DROP_OLDEST
+				head = (head + 1) % CRANE_BUFFER_SLOTS; count--; dropped++;
+#else
+				rejected++;
+				if(added) { errors++; printf("FAIL: entry %lu was added to a full buffer\n", (unsigned long)nextId); }
+				nextId++;
+				continue;
+#endif
+			}
+			if(!added) { errors++; printf("FAIL: entry %lu was rejected with %d entries in the buffer\n", (unsigned long)nextId, count); continue; }
+			ids[(head + count) % CRANE_BUFFER_SLOTS] = nextId++;
+			lengths[(head + count) % CRANE_BUFFER_SLOTS] = length;
+			count++;
+			pushed++;
+		}
+		else
+		{
+			uint8_t length = crane.readBuffer(read, sizeof(read));
+			if(!count)
+			{
+				if(length) { errors++; printf("FAIL: read %d bytes from an empty buffer\n", length); }
+				continue;
+			}
+			fill(entry, lengths[head], ids[head]);
+			if(length != lengths[head] || memcmp(read, entry, length))
+				{ errors++; printf("FAIL: cycle %lu: expected entry %lu (%d bytes), read %d bytes\n", c, (unsigned long)ids[head], lengths[head], length); }
+			head = (head + 1) % CRANE_BUFFER_SLOTS;
+			count--;
+			popped++;
+			if(!head) wraps++;
+		}
+		
+		if(crane.available() != count) { errors++; printf("FAIL: cycle %lu: %d entries available, expected %d\n", c, crane.available(), count); }
+	}
+	counting = false;
+	
+	printf("%lu cycles: %lu pushed, %lu popped, %lu rejected, %lu dropped, %lu wraparounds, %lu heap allocations\n", STRESS_CYCLES, pushed, popped, rejected, dropped, wraps, allocations);
+	CHECK(!errors, "%lu errors", errors);
+	CHECK(!allocations, "%lu heap allocations", allocations);
+	CHECK(crane.bufferOverflows == (uint16_t)(rejected + dropped), "%d overflows counted, expected %lu", crane.bufferOverflows, rejected + dropped);
+	CHECK(wraps > 1000 && rejected + dropped > 1000, "the buffer did not wrap or fill up often enough");
+	return hostResult();
+}
@@ -0,0 +1,113 @@
+/// The self test of arduino 2, and its ping replies
+/// The self test only times the step engine (the steppers run open loop): a tick that runs too fast or not at all has to fail it.
+/// Pings have to be answered during the test (with the result) and after it
+
+#include "Crane.h"
+#include "host.h"
+
+static uint8_t selfResult;									//The last stepperTest sent to arduino 1 (0xFF: none)
+static int okReplies;										//The amount of ping replies sent
+
+/// Decodes one message sent over I2C
+///
+static void decode(const uint8_t* data, uint8_t length)
+{
+	uint8_t opcode, seq;
+	int32_t a, b;
+	if(!Crane::decodeFrame(data, length, opcode, seq, a, b)) return;
+	if(opcode == CRANE_OP_SELF) selfResult = a;
+	if(opcode == CRANE_OP_OK && a == 2) okReplies++;
+}
+
+/// Reads every transmission, unpacking batches
+///
+static uint8_t onTransmit(uint8_t address, const uint8_t* data, uint8_t length)
+{
+	if(length && data[0] == CRANE_OP_BATCH)
+	{
+		for(uint8_t i = 1; i < length && i + 1 + data[i] <= length; i += 1 + data[i]) decode(data + i + 1, data[i]);
+	}
+	else decode(data, length);
+	return 0;
+}
+
+/// Sends the crane a ping
+///
+static void ping(Crane& crane)
+{
+	uint8_t frame[CRANE_FRAME_MAX];
+	uint8_t length = Crane::encodeFrame(frame, CRANE_OP_PING, 0, 0, 0);
+	hostReceive(crane, frame, length);
+}
+
+/// Runs the crane for 'ms' milliseconds: 'ticks' ticks of 50 microseconds and one update() per millisecond
+///
+static void run(Crane& crane, unsigned long ms, uint8_t ticks)
+{
+	for(unsigned long t = 0; t < ms; t++)
+	{
+		for(uint8_t i = 0; i < ticks; i++) crane.tick();
+		hostMicros += 1000;
+		crane.update();
+	}
+}
+
+/// Starts a self test with a ping pending, and runs it with 'ticks' ticks per millisecond
+///
+static Crane& selfTest(uint8_t ticks)
+{
+	hostReset();
+	Crane& crane = hostCrane(2);
+	hostOnTransmit = onTransmit;
+	selfResult = 0xFF;
+	okReplies = 0;
+	crane.startTicker(20000);
+	
+	crane.verify();
+	ping(crane);
+	run(crane, 4 * CRANE_SELFTEST_TIME + 500, ticks);
+	return crane;
+}
+
+/// A step engine running at the right rate passes, and answers the ping sent during the test
+///
+static void passes()
+{
+	Crane& crane = selfTest(20);
+	printf("20 ticks/ms: result %d, %d ping replies\n", selfResult, okReplies);
+	CHECK(selfResult == 7, "the self test sent %d, expected 7", selfResult);
+	CHECK(okReplies == 1, "%d replies to the ping during the test, expected 1", okReplies);
+	
+	//-------------------------------- Pings after the test are answered by update2
+	ping(crane);
+	run(crane, 10, 20);
+	ping(crane);
+	run(crane, 10, 20);
+	CHECK(okReplies == 3, "%d ping replies after two more pings, expected 3", okReplies);
+}
+
+/// A step engine that runs twice as fast as it thinks it does fails
+///
+static void tooFast()
+{
+	selfTest(40);
+	printf("40 ticks/ms: result %d\n", selfResult);
+	CHECK(selfResult == 0, "the self test sent %d, expected 0", selfResult);
+}
+
+/// A step engine that does not run at all fails (by timeout)
+///
+static void stalled()
+{
+	selfTest(0);
+	printf("no ticks: result %d\n", selfResult);
+	CHECK(selfResult == 0, "the self test sent %d, expected 0", selfResult);
+}
+
+int main()
+{
+	passes();
+	tooFast();
+	stalled();
+	return hostResult();
+}
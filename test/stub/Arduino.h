@@ -0,0 +1,136 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+//-------------------------------- The parts of the Arduino core the Crane library uses, for building it on a PC (see host.h for the simulated board behind it)
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define A6 20
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+#define PROGMEM
+#define PGM_P const char*
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper*)(s))
+
+#define B00000 0
+#define B00010 2
+#define B00100 4
+#define B01000 8
+#define B01010 10
+#define B01110 14
+#define B10000 16
+#define B10001 17
+#define B10100 20
+#define B11111 31
+
+#define constrain(a,l,h) ((a)<(l)?(l):((a)>(h)?(h):(a)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void noInterrupts();
+void interrupts();
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+
+//-------------------------------- The I/O registers of the ATmega328P that CRANE_FAST_GPIO uses (avr/io.h on the Arduino), for building that path on a PC
+//-------------------------------- PORTD and PORTB drive pins 0-7 and 8-13, so their steps are counted as those of digitalWrite are. Every access counts its cycles in hostCycles
+#define HOST_DIGITALWRITE_CYCLES 56										//The cycles of one digitalWrite of the AVR core: the pin tables in flash, the PWM check, and a read-modify-write with the interrupts off
+
+extern thread_local unsigned long hostCycles;							//The cycles spent on the pins: 1 per I/O register access (in, out), HOST_DIGITALWRITE_CYCLES per digitalWrite
+
+struct HostPort
+{
+	uint8_t first;															//The pin behind bit 0
+	operator uint8_t() const;												//Reads the levels of the pins
+	HostPort& operator=(uint8_t value);										//Sets the pins whose bit changed
+	HostPort& operator|=(uint8_t bits) { return *this = *this | bits; }
+	HostPort& operator&=(uint8_t bits) { return *this = *this & bits; }
+};
+
+struct HostStatus
+{
+	operator uint8_t() const;												//Bit 7 (I) is set while the interrupts are on
+	HostStatus& operator=(uint8_t value);									//Turns the interrupts on or off, as bit 7 says
+};
+
+extern HostPort PORTD, PORTB, PIND, PINB;
+extern HostStatus SREG;
+inline void cli() { hostCycles++; noInterrupts(); }
+
+/// A String, backed by std::string
+///
+class String
+{
+	public:
+	String(const char* text = "") : s(text) {}
+	String(int value) : s(std::to_string(value)) {}
+	const char* c_str() const { return s.c_str(); }
+	unsigned int length() const { return s.size(); }
+	friend String operator+(const String& a, const String& b) { String r; r.s = a.s + b.s; return r; }
+	String& operator+=(char c) { s += c; return *this; }
+	bool operator==(const char* other) const { return s == other; }
+	bool operator!=(const char* other) const { return s != other; }
+	char* begin() { return &s[0]; }
+	char* end() { return &s[0] + s.size(); }
+	std::string s;
+};
+
+/// Print and Serial: text is thrown away. Serial can keep what is written to it in binary (see HardwareSerial::written)
+///
+class Print
+{
+	public:
+	template<class T> size_t print(T) { return 0; }
+	template<class T> size_t print(T, int) { return 0; }
+	template<class T> size_t println(T) { return 0; }
+	template<class T> size_t println(T, int) { return 0; }
+	size_t println() { return 0; }
+	size_t write(uint8_t) { return 1; }
+	size_t write(const uint8_t*, size_t n) { return n; }
+	size_t write(const char*) { return 0; }
+};
+
+class HardwareSerial : public Print
+{
+	public:
+	void begin(long) {}
+	int available() { return 0; }
+	int read() { return -1; }
+	int availableForWrite() { return room; }
+	size_t write(uint8_t c) { return write(&c, 1); }
+	size_t write(const uint8_t* data, size_t n) { if(written) written->append((const char*)data, n); return n; }
+	using Print::write;
+	
+	std::string* written = 0;												//If set, write appends the bytes here
+	int room = 63;															//What availableForWrite returns: the free space of the transmit buffer
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef LiquidCrystal_h
+#define LiquidCrystal_h
+
+#include "Arduino.h"
+
+/// LiquidCrystal: nothing is shown
+///
+class LiquidCrystal : public Print
+{
+	public:
+	LiquidCrystal(uint8_t, uint8_t, uint8_t, uint8_t, uint8_t, uint8_t) {}
+	void begin(uint8_t, uint8_t) {}
+	void clear() {}
+	void home() {}
+	void setCursor(uint8_t, uint8_t) {}
+	void scrollDisplayLeft() {}
+	void createChar(uint8_t, uint8_t*) {}
+};
+
+#endif
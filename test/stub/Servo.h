@@ -0,0 +1,11 @@
+#ifndef Servo_h
+#define Servo_h
+
+class Servo
+{
+	public:
+	void attach(int) {}
+	void write(int) {}
+};
+
+#endif
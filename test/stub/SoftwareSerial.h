@@ -0,0 +1,22 @@
+#ifndef SoftwareSerial_h
+#define SoftwareSerial_h
+
+#include "Arduino.h"
+
+/// SoftwareSerial: output is thrown away, a test hands it the bytes to receive with receive()
+///
+class SoftwareSerial : public Print
+{
+	public:
+	SoftwareSerial(uint8_t, uint8_t) {}
+	void begin(long) {}
+	bool listen() { return true; }
+	int available() { return _inLength - _inRead; }
+	int read() { return _inRead < _inLength ? _in[_inRead++] : -1; }
+	void receive(const uint8_t* data, size_t length) { _in = data; _inLength = length; _inRead = 0; }
+	
+	const uint8_t* _in = 0;
+	size_t _inLength = 0, _inRead = 0;
+};
+
+#endif
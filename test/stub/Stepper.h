@@ -0,0 +1,4 @@
+#ifndef Stepper_h
+#define Stepper_h
+
+#endif
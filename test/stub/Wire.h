@@ -0,0 +1,31 @@
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+/// The Wire library, on the simulated board: transmissions go to hostOnTransmit, and hostReceive hands the receive callback its bytes (see host.h)
+/// The receive callback reads the Wire of the thread that calls it, so a simulated bus can hand a board the bytes from the sending thread
+///
+class TwoWire
+{
+	public:
+	void begin() {}
+	void begin(uint8_t) {}
+	void beginTransmission(uint8_t address) { _address = address; _length = 0; }
+	size_t write(uint8_t c) { if(_length == 32) return 0; _tx[_length++] = c; return 1; }
+	size_t write(const uint8_t* data, size_t n) { size_t i = 0; while(i < n && write(data[i])) i++; return i; }
+	uint8_t endTransmission();
+	int available() { return _rxLength - _rxRead; }
+	int read() { return _rxRead < _rxLength ? _rx[_rxRead++] : -1; }
+	void onReceive(void (*)(int)) {}
+	
+	uint8_t _address = 0, _length = 0, _tx[32];
+	uint8_t _rxLength = 0, _rxRead = 0, _rx[32];
+};
+
+void hostAcknowledge(uint8_t address, bool on);						//The TWEA bit of the board at 'address': false, and the bus gets a NACK for it (see host.h)
+#define CRANE_WIRE_ACK(arduino, on) hostAcknowledge(arduino, on)
+
+extern thread_local TwoWire Wire;									//One per board: each thread is a board (see host.h)
+
+#endif
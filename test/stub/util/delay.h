@@ -0,0 +1,10 @@
+#ifndef util_delay_h
+#define util_delay_h
+
+//-------------------------------- The busy-wait of avr-libc, on the simulated board: it moves the clock like delayMicroseconds, and costs no cycles of pin access
+
+#include "Arduino.h"
+
+inline void _delay_us(double us) { delayMicroseconds((unsigned int)us); }
+
+#endif
@@ -0,0 +1,180 @@
+/// The telemetry of the library: record, processTelemetry and decodeTelemetry, on the bytes that go out over Serial
+/// Checks the round trip of the samples (every field, negative values, the order), the batching and the ring overflow, the rate limit of
+/// telemetryInterval, that nothing is sent (or lost) while the Serial buffer has no room for the frame, and that decodeTelemetry
+/// takes no malformed or truncated frame
+
+#include "Crane.h"
+#include "host.h"
+#include <string>
+#include <vector>
+
+static std::string out;										//What was written to Serial
+
+/// A fresh crane that keeps what it writes to Serial, at 'ms'
+///
+static Crane& start(unsigned long ms)
+{
+	hostReset();
+	out.clear();
+	Serial.written = &out;
+	hostMicros = ms * 1000;
+	return hostCrane(1);
+}
+
+/// Splits the Serial output into frames, the way a reader does: a frame starts with CRANE_TM_SYNC, its count gives its length
+/// Returns the samples of all frames in order. 'frames' gets the amount of frames, 'broken' the amount that did not decode
+///
+static std::vector<CraneSample> readFrames(uint32_t* frames, uint32_t* broken)
+{
+	std::vector<CraneSample> samples;
+	*frames = *broken = 0;
+	size_t i = 0;
+	while(i + 2 <= out.size())
+	{
+		if((uint8_t)out[i] != CRANE_TM_SYNC) { i++; continue; }
+		uint8_t length = 3 + 6 * (uint8_t)out[i + 1];
+		CraneSample decoded[CRANE_TM_BATCH];
+		uint8_t count = i + length <= out.size() ? Crane::decodeTelemetry((const uint8_t*)out.data() + i, length, decoded) : 0;
+		if(!count) { (*broken)++; i++; continue; }
+		samples.insert(samples.end(), decoded, decoded + count);
+		(*frames)++;
+		i += length;
+	}
+	return samples;
+}
+
+/// Every field of every sample arrives as it was recorded, in order
+///
+static void roundTrip()
+{
+	Crane& crane = start(1000);
+	crane.record(CRANE_TM_DISTANCE, 0, 1234);
+	hostMicros += 3000;
+	crane.record(CRANE_TM_VELOCITY, 7, -321);
+	hostMicros += 65536000UL - 1000;
+	crane.record(CRANE_TM_GAVE_UP, 255, -32768);
+	crane.processTelemetry();
+
+	CHECK(out.size() == 3 + 6 * 3, "a frame of 3 samples was %d bytes", (int)out.size());
+	CraneSample samples[CRANE_TM_BATCH];
+	uint8_t count = Crane::decodeTelemetry((const uint8_t*)out.data(), out.size(), samples);
+	CHECK(count == 3, "%d samples decoded, not 3", count);
+	CHECK(samples[0].type == CRANE_TM_DISTANCE && samples[0].arg == 0 && samples[0].time == 1000 && samples[0].value == 1234, "the first sample came back as %d %d %u %d", samples[0].type, samples[0].arg, samples[0].time, samples[0].value);
+	CHECK(samples[1].type == CRANE_TM_VELOCITY && samples[1].arg == 7 && samples[1].time == 1003 && samples[1].value == -321, "the second sample came back as %d %d %u %d", samples[1].type, samples[1].arg, samples[1].time, samples[1].value);
+	CHECK(samples[2].type == CRANE_TM_GAVE_UP && samples[2].arg == 255 && samples[2].time == 1002 && samples[2].value == -32768, "the third sample (the time wrapped) came back as %d %d %u %d", samples[2].type, samples[2].arg, samples[2].time, samples[2].value);
+}
+
+/// A full ring drops what comes after, and is sent in frames of at most CRANE_TM_BATCH, one per interval
+///
+static void overflow()
+{
+	Crane& crane = start(1000);
+	for(int16_t i = 0; i < CRANE_TM_SLOTS + 3; i++) crane.record(CRANE_TM_BUFFER, i, i * 100);
+	CHECK(crane.telemetryDropped == 3, "%d samples dropped on a full ring, not 3", crane.telemetryDropped);
+
+	//-------------------------------- The first frame takes a batch. The rest has to wait for the interval, then comes in the next frame
+	crane.processTelemetry();
+	size_t first = out.size();
+	crane.processTelemetry();
+	CHECK(out.size() == first && first == 3 + 6 * CRANE_TM_BATCH, "the first frame was %d bytes, then %d more were sent within the interval", (int)first, (int)(out.size() - first));
+	hostMicros += crane.telemetryInterval * 1000UL;
+	crane.processTelemetry();
+
+	uint32_t frames, broken;
+	std::vector<CraneSample> samples = readFrames(&frames, &broken);
+	CHECK(frames == 2 && !broken && samples.size() == CRANE_TM_SLOTS, "%u frames, %u broken, %d samples", frames, broken, (int)samples.size());
+	for(uint8_t i = 0; i < samples.size(); i++)
+		CHECK(samples[i].arg == i && samples[i].value == i * 100, "sample %d came back as arg %d, value %d", i, samples[i].arg, samples[i].value);
+
+	//-------------------------------- The ring takes samples again once it is sent
+	crane.record(CRANE_TM_PUSH, 2, 1);
+	CHECK(crane.telemetryDropped == 3, "a sample was dropped after the ring was sent");
+}
+
+/// A sample every millisecond for 2 seconds, processTelemetry every millisecond: one frame per interval at most, and every sample
+/// is either sent, in order, or counted as dropped
+///
+static void rateLimit()
+{
+	Crane& crane = start(1000);
+	const uint32_t ms = 2000;
+	for(uint32_t t = 0; t < ms; t++)
+	{
+		crane.record(CRANE_TM_RECEIVED, 0, t);
+		crane.processTelemetry();
+		hostMicros += 1000;
+	}
+	uint32_t frames, broken;
+	std::vector<CraneSample> samples = readFrames(&frames, &broken);
+	bool ordered = true;
+	for(size_t i = 1; i < samples.size(); i++) if(samples[i].value <= samples[i - 1].value) ordered = false;
+	printf("rate: %u samples in %u ms: %u frames, %d samples sent, %u dropped\n", ms, ms, frames, (int)samples.size(), crane.telemetryDropped);
+	CHECK(frames <= ms / crane.telemetryInterval + 1 && frames >= ms / crane.telemetryInterval, "%u frames in %u ms, with an interval of %u ms", frames, ms, crane.telemetryInterval);
+	CHECK(!broken && ordered, "%u frames broken, the samples %s in order", broken, ordered ? "were" : "were not");
+	CHECK(samples.size() + crane.telemetryDropped <= ms && samples.size() + crane.telemetryDropped + CRANE_TM_SLOTS >= ms, "%d sent and %u dropped of %u (the rest still in the ring)", (int)samples.size(), crane.telemetryDropped, ms);
+}
+
+/// Without room for the whole frame in the Serial buffer, nothing is written and nothing is lost: the frame goes once there is room
+///
+static void noRoom()
+{
+	Crane& crane = start(1000);
+	crane.record(CRANE_TM_DISTANCE, 0, 500);
+	crane.record(CRANE_TM_VELOCITY, 0, -20);
+	Serial.room = 3 + 6 * 2 - 1;
+	crane.processTelemetry();
+	hostMicros += crane.telemetryInterval * 1000UL;
+	crane.processTelemetry();
+	CHECK(out.empty(), "%d bytes were written with room for %d", (int)out.size(), Serial.room);
+
+	Serial.room = 3 + 6 * 2;
+	crane.processTelemetry();
+	CraneSample samples[CRANE_TM_BATCH];
+	uint8_t count = Crane::decodeTelemetry((const uint8_t*)out.data(), out.size(), samples);
+	CHECK(count == 2 && samples[0].value == 500 && samples[1].value == -20, "once there was room, %d samples arrived", count);
+}
+
+/// Malformed and truncated frames decode to 0 samples
+///
+static void malformed()
+{
+	Crane& crane = start(1000);
+	for(int16_t i = 0; i < 3; i++) crane.record(CRANE_TM_SEND, 3, i);
+	crane.processTelemetry();
+	std::vector<uint8_t> good(out.begin(), out.end());
+	CraneSample samples[CRANE_TM_BATCH];
+	CHECK(Crane::decodeTelemetry(good.data(), good.size(), samples) == 3, "the frame itself did not decode");
+
+	//-------------------------------- Every truncation, and a byte too many
+	for(uint8_t length = 0; length < good.size(); length++)
+		CHECK(!Crane::decodeTelemetry(good.data(), length, samples), "the frame cut to %d bytes decoded", length);
+	std::vector<uint8_t> longer = good;
+	longer.push_back(0);
+	CHECK(!Crane::decodeTelemetry(longer.data(), longer.size(), samples), "the frame with a byte too many decoded");
+
+	//-------------------------------- Every single bit flipped (the sync, the count, a sample or the CRC)
+	for(uint8_t i = 0; i < good.size(); i++) for(uint8_t bit = 0; bit < 8; bit++)
+	{
+		std::vector<uint8_t> bad = good;
+		bad[i] ^= 1 << bit;
+		CHECK(!Crane::decodeTelemetry(bad.data(), bad.size(), samples), "the frame with bit %d of byte %d flipped decoded", bit, i);
+	}
+
+	//-------------------------------- A count of 0, and one over CRANE_TM_BATCH, even with a matching CRC and length
+	uint8_t empty[3] = { CRANE_TM_SYNC, 0, 0 };
+	empty[2] = Crane::crc8(empty + 1, 1);
+	CHECK(!Crane::decodeTelemetry(empty, sizeof(empty), samples), "a frame of 0 samples decoded");
+	uint8_t big[CRANE_TM_FRAME_MAX + 6] = { CRANE_TM_SYNC, CRANE_TM_BATCH + 1 };
+	big[sizeof(big) - 1] = Crane::crc8(big + 1, sizeof(big) - 2);
+	CHECK(!Crane::decodeTelemetry(big, sizeof(big), samples), "a frame of %d samples decoded", CRANE_TM_BATCH + 1);
+}
+
+int main()
+{
+	roundTrip();
+	overflow();
+	rateLimit();
+	noRoom();
+	malformed();
+	return hostResult();
+}
@@ -0,0 +1,142 @@
+/// The tick simulator of the step engine (arduino 2)
+/// Runs moves through Crane::tick() at 10, 20 and 40 kHz, counts the steps on the STEP pins, and measures how far each step lands from its ideal time.
+/// The DDA can only step on a tick, so every step has to be within one tick period of its ideal time
+
+#include "Crane.h"
+#include "host.h"
+
+static unsigned long lastStep[3];							//When each axis last stepped (microseconds), 0: not yet
+static long intervalMin[3], intervalMax[3];					//The shortest and longest time in between two steps of each axis
+static long measureFrom = 0;								//Intervals are only measured from this step on
+
+static void onStep(uint8_t axis, bool forward)
+{
+	long taken = forward ? hostSteps[axis] : -hostSteps[axis];
+	if(lastStep[axis] && taken > measureFrom)
+	{
+		long interval = hostMicros - lastStep[axis];
+		if(interval < intervalMin[axis]) intervalMin[axis] = interval;
+		if(interval > intervalMax[axis]) intervalMax[axis] = interval;
+	}
+	lastStep[axis] = hostMicros;
+}
+
+/// Runs the step engine until it is idle, one tick every 1/hz seconds (the rates used divide a second evenly). Returns the amount of ticks
+///
+static long runTicks(Crane& crane, uint32_t hz, long limit)
+{
+	unsigned long start = hostMicros;
+	long ticks = 0;
+	while(crane.isMoving() && ticks < limit)
+	{
+		ticks++;
+		hostMicros = start + ticks * (1000000 / hz);
+		crane.tick();
+	}
+	return ticks;
+}
+
+static void startRun()
+{
+	hostReset();
+	hostOnStep = onStep;
+	for(uint8_t a = 0; a < 3; a++) { lastStep[a] = 0; intervalMin[a] = 0x7FFFFFFF; intervalMax[a] = 0; }
+	measureFrom = 0;
+}
+
+/// One linear move of all three axes, 1 second long: the counts have to be exact, and the intervals within one tick of the ideal
+///
+static void linearMove(uint32_t hz)
+{
+	const int32_t steps[3] = {997, -333, 7};
+	startRun();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(hz);
+	crane.moveSteps(steps[0], steps[1], steps[2], 1000000UL);
+	long ticks = runTicks(crane, hz, 2 * hz);
+	
+	long tick = 1000000 / hz;
+	printf("%5lu Hz: %ld ticks, steps %ld %ld %ld\n", (unsigned long)hz, ticks, hostSteps[0], hostSteps[1], hostSteps[2]);
+	for(uint8_t a = 0; a < 3; a++)
+	{
+		CHECK(hostSteps[a] == steps[a], "%lu Hz: axis %d took %ld steps, expected %ld", (unsigned long)hz, a + 1, hostSteps[a], (long)steps[a]);
+		CHECK(crane.positionOf(a + 1) == steps[a], "%lu Hz: axis %d counted %ld, expected %ld", (unsigned long)hz, a + 1, (long)crane.positionOf(a + 1), (long)steps[a]);
+		
+		//-------------------------------- The followers step on a step of the dominant axis, so their ideal interval is rounded to whole dominant intervals
+		long n = steps[a] < 0 ? -steps[a] : steps[a];
+		long ideal = 1000000 / n;
+		long slack = tick + (a ? 1000000 / steps[0] + 1 : 1);
+		if(n > 1)
+		{
+			printf("         axis %d: interval %ld..%ld us (ideal %ld, jitter %ld us)\n", a + 1, intervalMin[a], intervalMax[a], ideal,
+				intervalMax[a] - ideal > ideal - intervalMin[a] ? intervalMax[a] - ideal : ideal - intervalMin[a]);
+			CHECK(intervalMin[a] >= ideal - slack && intervalMax[a] <= ideal + slack, "%lu Hz: axis %d interval %ld..%ld us, ideal %ld +-%ld", (unsigned long)hz, a + 1, intervalMin[a], intervalMax[a], ideal, slack);
+		}
+	}
+	CHECK(ticks >= (long)hz - 1 && ticks <= (long)hz + 1, "%lu Hz: the move took %ld ticks", (unsigned long)hz, ticks);
+}
+
+/// A move faster than the tick rate, followed by a slow one: the engine steps once per tick at most, and the slow move must not start with a burst
+///
+static void fasterThanTick(uint32_t hz)
+{
+	startRun();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(hz);
+	crane.moveSteps(400, 0, 0, 1000UL);
+	long ticks = runTicks(crane, hz, 10 * hz);
+	CHECK(hostSteps[0] == 400, "%lu Hz: the fast move took %ld steps", (unsigned long)hz, hostSteps[0]);
+	CHECK(ticks == 400, "%lu Hz: the fast move took %ld ticks, expected one step per tick", (unsigned long)hz, ticks);
+	
+	//-------------------------------- The same move with a slow one queued behind it (loaded back to back, so the phase carries over). No step of the slow move may come early
+	startRun();
+	measureFrom = 400;
+	crane.moveSteps(400, 0, 0, 1000UL);
+	hostMicros = 1000000 / hz;
+	crane.tick();
+	crane.moveSteps(10, 0, 0, 100000UL);
+	runTicks(crane, hz, 10 * hz);
+	long tick = 1000000 / hz;
+	printf("%5lu Hz: 400 steps in 1 ms took %ld ticks, then 10 steps of 10000 us: interval %ld..%ld us\n", (unsigned long)hz, ticks, intervalMin[0], intervalMax[0]);
+	CHECK(hostSteps[0] == 410, "%lu Hz: %ld steps, expected 410", (unsigned long)hz, hostSteps[0]);
+	CHECK(intervalMin[0] >= 10000 - tick && intervalMax[0] <= 10000 + tick, "%lu Hz: the slow move stepped %ld..%ld us apart, expected 10000 +-%ld", (unsigned long)hz, intervalMin[0], intervalMax[0], tick);
+}
+
+/// Speed commands during a move must not touch the direction pins: the running move keeps its direction, and the step count on the pins matches positionOf.
+/// The new direction starts with the next chunk of stepSync
+static void speedDuringMove()
+{
+	startRun();
+	Crane& crane = hostCrane(2);
+	crane.startTicker(20000);
+	crane.setSpeedOf(1, 1);
+	crane.stepSync();
+	
+	//-------------------------------- Reverse the speed halfway through the first chunk, and try to step by hand
+	for(uint16_t t = 0; t < 100; t++) { hostMicros += 50; crane.tick(); }
+	long forward = hostSteps[0];
+	crane.setSpeedOf(1, -1);
+	crane.step(1, false);
+	CHECK(hostPin[3] == HIGH, "the direction pin was switched during the move");
+	CHECK(hostSteps[0] == forward, "step() moved the stepper during the move");
+	
+	//-------------------------------- Run on with stepSync: the first chunk finishes forward, then the stepper turns
+	for(uint32_t t = 0; t < 20000; t++)
+	{
+		if(t % 20 == 0) crane.stepSync();
+		hostMicros += 50;
+		crane.tick();
+	}
+	printf("speed reversed during a move: %ld steps on the pins, position %ld\n", hostSteps[0], (long)crane.positionOf(1));
+	CHECK(hostSteps[0] == crane.positionOf(1), "the pins took %ld steps, the engine counted %ld", hostSteps[0], (long)crane.positionOf(1));
+	CHECK(hostSteps[0] < 0, "the stepper did not turn");
+}
+
+int main()
+{
+	const uint32_t rates[] = {10000, 20000, 40000};
+	for(uint8_t i = 0; i < 3; i++) linearMove(rates[i]);
+	for(uint8_t i = 0; i < 3; i++) fasterThanTick(rates[i]);
+	speedDuringMove();
+	return hostResult();
+}